@@ -17,7 +17,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
-#ifdef USE_PEXT
+#if defined(USE_PEXT) || defined(__AVX2__)
 #include <immintrin.h>
 #endif
 
@@ -51,19 +51,71 @@ const int ROOK_RELEVANT_BITS[64] = {12, 11, 11, 11, 11, 11, 11, 12, //
                                     11, 10, 10, 10, 10, 10, 10, 11, //
                                     12, 11, 11, 11, 11, 11, 11, 12};
 
+#ifndef PREBUILT_TABLES
 BitBoard BETWEEN_SQS[64][64];
 BitBoard PINNED_MOVES[64][64];
+#endif
 
+// Generated once with FindMagicNumber, these only need to be found again
+// if the masks or relevant bits change
+const uint64_t BISHOP_MAGICS[64] = {0x0020828081010200ull, 0x4020410421004045ull, 0x4084080081030428ull, //
+                                    0x2002208200400040ull, 0x40240504102d0220ull, 0x000a081424100200ull, //
+                                    0x0004108410080200ull, 0x4040808050108400ull, 0x2004420822041042ull, //
+                                    0x0006101000890054ull, 0x06085010c0810800ull, 0x08000444008a080cull, //
+                                    0x000a0d1041001000ull, 0x1040008220600200ull, 0x0010110110100400ull, //
+                                    0x00000830880c1040ull, 0x8840400510041108ull, 0x0502000818510400ull, //
+                                    0x02411008080b0010ull, 0x800406084400080eull, 0x4801004590400190ull, //
+                                    0x8101000080603200ull, 0x0301110044100400ull, 0x004020208a080200ull, //
+                                    0x010844180aa01800ull, 0x0904204004588880ull, 0x1218510908020400ull, //
+                                    0x9008080040202120ull, 0x0120840202802000ull, 0x5118024004806020ull, //
+                                    0x0942088684040120ull, 0x0009010190440891ull, 0x3041101021882010ull, //
+                                    0x1000822040080801ull, 0x0410280800010a00ull, 0xc020400808038200ull, //
+                                    0x0204200200402080ull, 0x8090004200134100ull, 0x8110010304204460ull, //
+                                    0x4021086200018a00ull, 0xc10808a208a01000ull, 0x0024308818048410ull, //
+                                    0x4002010448004101ull, 0x0402012011008802ull, 0x0000102012000041ull, //
+                                    0x00a1014101004200ull, 0x0002820424008108ull, 0xa210010069010880ull, //
+                                    0x0800421011082208ull, 0x8000804842102000ull, 0x0400050088040015ull, //
+                                    0x0001020084043004ull, 0x02250c4010410040ull, 0x200c910210010000ull, //
+                                    0x0a12029004108000ull, 0x8028c84284014009ull, 0x00053c0200a2e000ull, //
+                                    0x1060102401080822ull, 0x800404420082210dull, 0x0100708002050412ull, //
+                                    0x1100404240105100ull, 0x08202120081042c0ull, 0x0600204801082480ull, //
+                                    0x0a02a00202021220ull};
+
+const uint64_t ROOK_MAGICS[64] = {0x80800015c0082080ull, 0x00c0100140002000ull, 0x0100104009042000ull, //
+                                  0x0480080080100004ull, 0x1080040008008002ull, 0x1200080410020001ull, //
+                                  0x030004ca00040500ull, 0x408000a480004900ull, 0x0422800024904000ull, //
+                                  0x6000400050002001ull, 0x1221002005021240ull, 0x0000808008001000ull, //
+                                  0x2050808004000800ull, 0x0042000200080410ull, 0x1004000241084410ull, //
+                                  0x080200040484690aull, 0x81c0808000284004ull, 0x09c0018020008040ull, //
+                                  0x4000420020801200ull, 0x4008008010000882ull, 0x8038008004008008ull, //
+                                  0x0802808002000400ull, 0x0c10440021020890ull, 0x0000020000840041ull, //
+                                  0x0080005040002001ull, 0x0000400480200080ull, 0x0000104100200101ull, //
+                                  0x0010001080800800ull, 0x0000040080800800ull, 0x2048020080040080ull, //
+                                  0x0880120400810850ull, 0x028809020004884cull, 0x2440102040800086ull, //
+                                  0x1020100020404000ull, 0x0861200184801000ull, 0x0200801000800800ull, //
+                                  0x0010080080800400ull, 0x2202001002000409ull, 0x04401022040008a1ull, //
+                                  0x0802049106000054ull, 0x0040804000228000ull, 0x0050004020014010ull, //
+                                  0x2020200010008080ull, 0x0010008100080800ull, 0x0028000400088080ull, //
+                                  0x4112010488020010ull, 0x0462000408020001ull, 0x10400ca841020004ull, //
+                                  0x8006320146810200ull, 0x0000812000400280ull, 0x0010144020090100ull, //
+                                  0x008a001008452200ull, 0x0018004004020040ull, 0x0020020004008080ull, //
+                                  0x0006011002080400ull, 0x0000024700b40200ull, 0x0000410080002011ull, //
+                                  0x040811042182c001ull, 0x58201041000a2001ull, 0x0c00041001210009ull, //
+                                  0x000200846010182aull, 0x0001000208040013ull, 0x9005000082002441ull, //
+                                  0x0484802102c40186ull};
+
+#ifndef PREBUILT_TABLES
 BitBoard PAWN_ATTACKS[2][64];
 BitBoard KNIGHT_ATTACKS[64];
-BitBoard BISHOP_ATTACKS[64][512];
-BitBoard ROOK_ATTACKS[64][4096];
 BitBoard KING_ATTACKS[64];
 BitBoard ROOK_MASKS[64];
 BitBoard BISHOP_MASKS[64];
 
-uint64_t ROOK_MAGICS[64];
-uint64_t BISHOP_MAGICS[64];
+// Fancy magics, each square gets exactly 2^relevant bits entries of one
+// shared table instead of a fixed 512/4096 stride (PEXT indexes the same)
+BitBoard SLIDER_ATTACKS[BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE];
+BitBoard* BISHOP_ATTACKS[64];
+BitBoard* ROOK_ATTACKS[64];
 
 void InitBetweenSquares() {
   int i;
@@ -145,6 +197,8 @@ void InitPinnedMovementSquares() {
   }
 }
 
+#endif
+
 inline BitBoard BetweenSquares(int from, int to) {
   return BETWEEN_SQS[from][to];
 }
@@ -153,6 +207,7 @@ inline BitBoard PinnedMoves(int p, int k) {
   return PINNED_MOVES[p][k];
 }
 
+#ifndef PREBUILT_TABLES
 BitBoard GetGeneratedPawnAttacks(int sq, int color) {
   BitBoard attacks = 0, board = 0;
 
@@ -394,22 +449,16 @@ uint64_t FindMagicNumber(int sq, int n, int isBishop) {
   return 0;
 }
 
-void InitBishopMagics() {
-  for (int i = 0; i < 64; i++)
-    BISHOP_MAGICS[i] = FindMagicNumber(i, BISHOP_RELEVANT_BITS[i], 1);
-}
-
-void InitRookMagics() {
-  for (int i = 0; i < 64; i++)
-    ROOK_MAGICS[i] = FindMagicNumber(i, ROOK_RELEVANT_BITS[i], 0);
-}
-
 void InitBishopAttacks() {
+  BitBoard* table = SLIDER_ATTACKS;
+
   for (int sq = 0; sq < 64; sq++) {
     BitBoard mask = BISHOP_MASKS[sq];
     int bits      = BISHOP_RELEVANT_BITS[sq];
     int n         = (1 << bits);
 
+    BISHOP_ATTACKS[sq] = table;
+
     for (int i = 0; i < n; i++) {
       BitBoard occupancy = SetPieceLayoutOccupancy(i, bits, mask);
 
@@ -420,15 +469,21 @@ void InitBishopAttacks() {
       BISHOP_ATTACKS[sq][_pext_u64(occupancy, mask)] = GetBishopAttacksOTF(sq, occupancy);
 #endif
     }
+
+    table += n;
   }
 }
 
 void InitRookAttacks() {
+  BitBoard* table = SLIDER_ATTACKS + BISHOP_TABLE_SIZE;
+
   for (int sq = 0; sq < 64; sq++) {
     BitBoard mask = ROOK_MASKS[sq];
     int bits      = ROOK_RELEVANT_BITS[sq];
     int n         = (1 << bits);
 
+    ROOK_ATTACKS[sq] = table;
+
     for (int i = 0; i < n; i++) {
       BitBoard occupancy = SetPieceLayoutOccupancy(i, bits, mask);
 
@@ -439,6 +494,8 @@ void InitRookAttacks() {
       ROOK_ATTACKS[sq][_pext_u64(occupancy, mask)]   = GetRookAttacksOTF(sq, occupancy);
 #endif
     }
+
+    table += n;
   }
 }
 
@@ -453,14 +510,10 @@ void InitAttacks() {
   InitBishopMasks();
   InitRookMasks();
 
-#ifndef USE_PEXT
-  InitBishopMagics();
-  InitRookMagics();
-#endif
-
   InitBishopAttacks();
   InitRookAttacks();
 }
+#endif
 
 inline BitBoard GetPawnAttacks(int sq, int color) {
   return PAWN_ATTACKS[color][sq];
@@ -514,6 +567,89 @@ inline BitBoard GetPieceAttacks(int sq, BitBoard occupancy, const int type) {
   return 0;
 }
 
+// Kogge-Stone occluded fills, the attacks of every slider in a set at once
+// without going near the attack tables. Rook rays are N, S, E, W and bishop
+// rays are NE, NW, SE, SW, each with the mask that stops it wrapping a file.
+// Every shift is split into a left and a right count, the unused one is 64
+// (or more) which shifts the lane out to 0. Only worth it with vectors, other
+// builds look the attacks up per piece.
+#if defined(__AVX512F__)
+static const int64_t FILL_LEFT[8]  = {64, 9, 7, 64, 64, 8, 1, 64};
+static const int64_t FILL_RIGHT[8] = {7, 64, 64, 9, 8, 64, 64, 1};
+static const int64_t FILL_MASKS[8] = {~A_FILE, ~A_FILE, ~H_FILE, ~H_FILE, ~0ULL, ~0ULL, ~A_FILE, ~H_FILE};
+
+INLINE __m512i FillShift(__m512i bb, __m512i left, __m512i right) {
+  return _mm512_or_si512(_mm512_sllv_epi64(bb, left), _mm512_srlv_epi64(bb, right));
+}
+
+inline void GetSliderAttacksFill(BitBoard diag,
+                                 BitBoard straight,
+                                 BitBoard occupancy,
+                                 BitBoard* diagAttacks,
+                                 BitBoard* straightAttacks) {
+  const __m512i l1   = _mm512_loadu_si512(FILL_LEFT);
+  const __m512i r1   = _mm512_loadu_si512(FILL_RIGHT);
+  const __m512i l2   = _mm512_add_epi64(l1, l1);
+  const __m512i r2   = _mm512_add_epi64(r1, r1);
+  const __m512i l4   = _mm512_add_epi64(l2, l2);
+  const __m512i r4   = _mm512_add_epi64(r2, r2);
+  const __m512i mask = _mm512_loadu_si512(FILL_MASKS);
+
+  __m512i gen = _mm512_mask_blend_epi64(0xf0, _mm512_set1_epi64(diag), _mm512_set1_epi64(straight));
+  __m512i pro = _mm512_and_si512(_mm512_set1_epi64(~occupancy), mask);
+
+  gen = _mm512_or_si512(gen, _mm512_and_si512(pro, FillShift(gen, l1, r1)));
+  pro = _mm512_and_si512(pro, FillShift(pro, l1, r1));
+  gen = _mm512_or_si512(gen, _mm512_and_si512(pro, FillShift(gen, l2, r2)));
+  pro = _mm512_and_si512(pro, FillShift(pro, l2, r2));
+  gen = _mm512_or_si512(gen, _mm512_and_si512(pro, FillShift(gen, l4, r4)));
+  gen = _mm512_and_si512(FillShift(gen, l1, r1), mask);
+
+  *diagAttacks     = _mm512_mask_reduce_or_epi64(0x0f, gen);
+  *straightAttacks = _mm512_mask_reduce_or_epi64(0xf0, gen);
+}
+#elif defined(__AVX2__)
+static const int64_t FILL_LEFT[2][4]  = {{64, 9, 7, 64}, {64, 8, 1, 64}};
+static const int64_t FILL_RIGHT[2][4] = {{7, 64, 64, 9}, {8, 64, 64, 1}};
+static const int64_t FILL_MASKS[2][4] = {{~A_FILE, ~A_FILE, ~H_FILE, ~H_FILE}, {~0ULL, ~0ULL, ~A_FILE, ~H_FILE}};
+
+INLINE __m256i FillShift(__m256i bb, __m256i left, __m256i right) {
+  return _mm256_or_si256(_mm256_sllv_epi64(bb, left), _mm256_srlv_epi64(bb, right));
+}
+
+INLINE BitBoard Fill(BitBoard sliders, BitBoard occupancy, const int straight) {
+  const __m256i l1   = _mm256_loadu_si256((const __m256i*) FILL_LEFT[straight]);
+  const __m256i r1   = _mm256_loadu_si256((const __m256i*) FILL_RIGHT[straight]);
+  const __m256i l2   = _mm256_add_epi64(l1, l1);
+  const __m256i r2   = _mm256_add_epi64(r1, r1);
+  const __m256i l4   = _mm256_add_epi64(l2, l2);
+  const __m256i r4   = _mm256_add_epi64(r2, r2);
+  const __m256i mask = _mm256_loadu_si256((const __m256i*) FILL_MASKS[straight]);
+
+  __m256i gen = _mm256_set1_epi64x(sliders);
+  __m256i pro = _mm256_and_si256(_mm256_set1_epi64x(~occupancy), mask);
+
+  gen = _mm256_or_si256(gen, _mm256_and_si256(pro, FillShift(gen, l1, r1)));
+  pro = _mm256_and_si256(pro, FillShift(pro, l1, r1));
+  gen = _mm256_or_si256(gen, _mm256_and_si256(pro, FillShift(gen, l2, r2)));
+  pro = _mm256_and_si256(pro, FillShift(pro, l2, r2));
+  gen = _mm256_or_si256(gen, _mm256_and_si256(pro, FillShift(gen, l4, r4)));
+  gen = _mm256_and_si256(FillShift(gen, l1, r1), mask);
+
+  __m128i x = _mm_or_si128(_mm256_castsi256_si128(gen), _mm256_extracti128_si256(gen, 1));
+  return _mm_cvtsi128_si64(x) | _mm_extract_epi64(x, 1);
+}
+
+inline void GetSliderAttacksFill(BitBoard diag,
+                                 BitBoard straight,
+                                 BitBoard occupancy,
+                                 BitBoard* diagAttacks,
+                                 BitBoard* straightAttacks) {
+  *diagAttacks     = Fill(diag, occupancy, 0);
+  *straightAttacks = Fill(straight, occupancy, 1);
+}
+#endif
+
 // get a bitboard of ALL pieces attacking a given square
 inline BitBoard AttacksToSquare(Board* board, int sq, BitBoard occ) {
   return (GetPawnAttacks(sq, WHITE) & PieceBB(PAWN, BLACK)) |                            // White and Black Pawn atx
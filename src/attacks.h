@@ -19,19 +19,23 @@
 
 #include "types.h"
 
-extern BitBoard BETWEEN_SQS[64][64];
-extern BitBoard PINNED_MOVES[64][64];
+#define BISHOP_TABLE_SIZE 5248
+#define ROOK_TABLE_SIZE   102400
 
-extern BitBoard PAWN_ATTACKS[2][64];
-extern BitBoard KNIGHT_ATTACKS[64];
-extern BitBoard BISHOP_ATTACKS[64][512];
-extern BitBoard ROOK_ATTACKS[64][4096];
-extern BitBoard KING_ATTACKS[64];
-extern BitBoard ROOK_MASKS[64];
-extern BitBoard BISHOP_MASKS[64];
+extern TABLE BitBoard BETWEEN_SQS[64][64];
+extern TABLE BitBoard PINNED_MOVES[64][64];
 
-extern uint64_t ROOK_MAGICS[64];
-extern uint64_t BISHOP_MAGICS[64];
+extern TABLE BitBoard PAWN_ATTACKS[2][64];
+extern TABLE BitBoard KNIGHT_ATTACKS[64];
+extern TABLE BitBoard SLIDER_ATTACKS[BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE];
+extern TABLE BitBoard* TABLE BISHOP_ATTACKS[64];
+extern TABLE BitBoard* TABLE ROOK_ATTACKS[64];
+extern TABLE BitBoard KING_ATTACKS[64];
+extern TABLE BitBoard ROOK_MASKS[64];
+extern TABLE BitBoard BISHOP_MASKS[64];
+
+extern const uint64_t BISHOP_MAGICS[64];
+extern const uint64_t ROOK_MAGICS[64];
 
 void InitBetweenSquares();
 void InitPinnedMovementSquares();
@@ -39,10 +43,8 @@ void initPawnSpans();
 void InitPawnAttacks();
 void InitKnightAttacks();
 void InitBishopMasks();
-void InitBishopMagics();
 void InitBishopAttacks();
 void InitRookMasks();
-void InitRookMagics();
 void InitRookAttacks();
 void InitKingAttacks();
 void InitAttacks();
@@ -70,4 +72,12 @@ BitBoard GetKingAttacks(int sq);
 BitBoard GetPieceAttacks(int sq, BitBoard occupancy, const int type);
 BitBoard AttacksToSquare(Board* board, int sq, BitBoard occ);
 
+#if defined(__AVX2__)
+void GetSliderAttacksFill(BitBoard diag,
+                          BitBoard straight,
+                          BitBoard occupancy,
+                          BitBoard* diagAttacks,
+                          BitBoard* straightAttacks);
+#endif
+
 #endif
@@ -22,6 +22,7 @@
 #include <string.h>
 
 #include "board.h"
+#include "cluster.h"
 #include "move.h"
 #include "search.h"
 #include "thread.h"
@@ -39,11 +40,12 @@ char* benchmarks[]            = {
 void Bench(int depth) {
   Board board;
 
-  Limits.depth   = depth;
-  Limits.multiPV = 1;
-  Limits.hitrate = INT_MAX;
-  Limits.max     = INT_MAX;
-  Limits.timeset = 0;
+  Limits.depth        = depth;
+  Limits.multiPV      = 1;
+  Limits.splitMultiPV = 0;
+  Limits.hitrate      = INT_MAX;
+  Limits.max          = INT_MAX;
+  Limits.timeset      = 0;
 
   Move bestMoves[NUM_BENCH_POSITIONS];
   int scores[NUM_BENCH_POSITIONS];
@@ -54,8 +56,7 @@ void Bench(int depth) {
   for (int i = 0; i < NUM_BENCH_POSITIONS; i++) {
     ParseFen(benchmarks[i], &board);
 
-    TTClear();
-    SearchClear();
+    NewGameClear();
 
     Limits.start = GetTimeMS();
     StartSearch(&board, 0);
@@ -83,5 +84,157 @@ void Bench(int depth) {
   for (int i = 0; i < NUM_BENCH_POSITIONS; i++)
     totalNodes += nodes[i];
 
-  printf("\nResults: %43" PRIu64 " nodes %8d nps\n\n", totalNodes, (int) (1000.0 * totalNodes / (totalTime + 1)));
-}
\ No newline at end of file
+  printf("\nResults: %43" PRIu64 " nodes %8d nps\n", totalNodes, (int) (1000.0 * totalNodes / (totalTime + 1)));
+  printf("Memory: %44" PRId64 " KB private\n\n", GetPrivateMemoryKB());
+}
+
+// Depth reached in a fixed time at increasing MultiPV, where the depth of a
+// position is that of its shallowest completed line
+void MultiPVBench(int moveTime) {
+  const int multiPVs[] = {1, 4, 10};
+
+  Board board;
+  SimpleMoveList rootMoves;
+
+  double avgDepths[3];
+  uint64_t totalNodes[3];
+
+  for (int k = 0; k < 3; k++) {
+    int depths    = 0;
+    totalNodes[k] = 0;
+
+    for (int i = 0; i < NUM_BENCH_POSITIONS; i++) {
+      ParseFen(benchmarks[i], &board);
+      RootMoves(&rootMoves, &board);
+
+      NewGameClear();
+
+      Limits.depth        = MAX_SEARCH_PLY - 1;
+      Limits.mate         = 0;
+      Limits.multiPV      = Min(multiPVs[k], rootMoves.count);
+      Limits.splitMultiPV = MULTI_PV_SPLIT && Limits.multiPV > 1 && Threads.count > 1;
+      Limits.searchMoves  = 0;
+      Limits.hitrate      = 1000;
+      Limits.nodes        = 0;
+      Limits.timeset      = 1;
+      Limits.alloc        = INT_MAX;
+      Limits.max          = moveTime;
+      Limits.infinite     = 0;
+
+      Limits.start = GetTimeMS();
+      StartSearch(&board, 0);
+      ThreadWaitUntilSleep(Threads.threads[0]);
+
+      int depth = MAX_SEARCH_PLY;
+      for (int j = 0; j < Limits.multiPV; j++)
+        depth = Min(depth, Threads.threads[0]->rootMoves[j].depth);
+
+      depths += depth;
+      totalNodes[k] += NodesSearched();
+    }
+
+    avgDepths[k] = (double) depths / NUM_BENCH_POSITIONS;
+  }
+
+  printf("\n\n");
+  for (int k = 0; k < 3; k++)
+    printf("MultiPV %2d: %6.2f depth %6.2f depth/s %12" PRIu64 " nodes\n",
+           multiPVs[k],
+           avgDepths[k],
+           1000.0 * avgDepths[k] / moveTime,
+           totalNodes[k]);
+  printf("\n");
+}
+
+// Cost of handing a trivial search to the pool and getting it back, from
+// StartSearch to every thread asleep again, at doubling thread counts
+void HandoffBench(int maxThreads) {
+  const int searches = 200;
+  const int restore  = Threads.count;
+
+  maxThreads = Min(2048, maxThreads);
+
+  Board board;
+  ParseFen(benchmarks[0], &board);
+
+  int counts[16], n = 0;
+  double avgs[16];
+
+  for (int t = 1; t <= maxThreads && n < 16; t *= 2) {
+    ThreadsSetNumber(t);
+    NewGameClear();
+
+    Limits.depth        = 1;
+    Limits.mate         = 0;
+    Limits.multiPV      = 1;
+    Limits.splitMultiPV = 0;
+    Limits.searchMoves  = 0;
+    Limits.hitrate      = INT_MAX;
+    Limits.max          = INT_MAX;
+    Limits.nodes        = 0;
+    Limits.timeset      = 0;
+    Limits.infinite     = 0;
+
+    int64_t start = GetTimeUS();
+    for (int i = 0; i < searches; i++) {
+      Limits.start = GetTimeMS();
+      StartSearch(&board, 0);
+      ThreadWaitUntilSleep(Threads.threads[0]);
+    }
+
+    counts[n] = t;
+    avgs[n++] = (double) (GetTimeUS() - start) / searches;
+  }
+
+  ThreadsSetNumber(restore);
+
+  printf("\n\n");
+  for (int k = 0; k < n; k++)
+    printf("Threads %3d: %10.1f us go -> bestmove\n", counts[k], avgs[k]);
+  printf("\n");
+}
+
+// Time to depth over the bench positions, searched by the coordinator alone
+// and then with one more connected worker process each round
+void ClusterBench(int depth) {
+  const int processes = ClusterPeers() + 1;
+
+  Board board;
+  char position[256];
+  long times[CLUSTER_MAX_PEERS + 1];
+
+  for (int k = 0; k < processes; k++) {
+    ClusterUsePeers(k);
+    times[k] = 0;
+
+    for (int i = 0; i < NUM_BENCH_POSITIONS; i++) {
+      ParseFen(benchmarks[i], &board);
+      snprintf(position, sizeof(position), "position fen %s", benchmarks[i]);
+      ClusterSetPosition(position, board.zobrist);
+
+      NewGameClear();
+
+      Limits.depth        = depth;
+      Limits.multiPV      = 1;
+      Limits.splitMultiPV = 0;
+      Limits.searchMoves  = 0;
+      Limits.hitrate      = INT_MAX;
+      Limits.max          = INT_MAX;
+      Limits.nodes        = 0;
+      Limits.timeset      = 0;
+      Limits.infinite     = 0;
+
+      Limits.start = GetTimeMS();
+      StartSearch(&board, 0);
+      ThreadWaitUntilSleep(Threads.threads[0]);
+      times[k] += GetTimeMS() - Limits.start;
+    }
+  }
+
+  ClusterUsePeers(-1);
+
+  printf("\n\n");
+  for (int k = 0; k < processes; k++)
+    printf("Processes %2d: %8ld ms to depth %d %6.2fx\n", k + 1, times[k], depth, (double) times[0] / Max(1, times[k]));
+  printf("\n");
+}
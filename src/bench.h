@@ -20,5 +20,8 @@
 #define DEFAULT_BENCH_DEPTH 13
 
 void Bench(int depth);
+void MultiPVBench(int moveTime);
+void HandoffBench(int maxThreads);
+void ClusterBench(int depth);
 
 #endif
\ No newline at end of file
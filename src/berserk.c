@@ -19,11 +19,14 @@
 #include "attacks.h"
 #include "bench.h"
 #include "bits.h"
+#include "cluster.h"
 #include "eval.h"
+#include "gentables.h"
 #include "nn/evaluate.h"
 #include "random.h"
 #include "search.h"
 #include "thread.h"
+#include "topology.h"
 #include "transposition.h"
 #include "types.h"
 #include "uci.h"
@@ -32,16 +35,25 @@
 
 // Welcome to berserk
 int main(int argc, char** argv) {
+  int64_t start = GetTimeUS();
+
+#ifndef PREBUILT_TABLES
   SeedRandom(0);
 
   InitZobristKeys();
   InitPruningAndReductionTables();
   InitAttacks();
   InitCuckoo();
+#endif
+  int64_t tables = GetTimeUS();
 
   LoadDefaultNN();
+  int64_t network = GetTimeUS();
+
+  TopologyInit();
   ThreadsInit();
   TTInit(16);
+  int64_t ready = GetTimeUS();
 
   // Compliance for OpenBench
   if (argc > 1 && !strncmp(argv[1], "bench", 5)) {
@@ -50,9 +62,27 @@ int main(int argc, char** argv) {
       depth = Max(1, atoi(argv[2]));
 
     Bench(depth);
+  } else if (argc > 1 && !strcmp(argv[1], "startup")) {
+#ifdef PREBUILT_TABLES
+    printf("tables   %8" PRId64 " us (prebuilt)\n", tables - start);
+#else
+    printf("tables   %8" PRId64 " us\n", tables - start);
+#endif
+    printf("network  %8" PRId64 " us\n", network - tables);
+    printf("threads  %8" PRId64 " us\n", ready - network);
+    printf("total    %8" PRId64 " us\n", ready - start);
+  } else if (argc > 2 && !strcmp(argv[1], "worker")) {
+    int threads = argc > 3 ? atoi(argv[3]) : 1;
+    int hash    = argc > 4 ? atoi(argv[4]) : 16;
+
+    ClusterWorker(argv[2], threads, hash);
+  } else if (argc > 3 && !strcmp(argv[1], "tables")) {
+    return !GenerateTables(argv[2], argv[3]);
   } else {
     UCILoop();
   }
 
+  ClusterExit();
+  TTFree();
   return 0;
 }
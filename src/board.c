@@ -41,6 +41,12 @@ const uint16_t KING_BUCKETS[64] = {15, 15, 14, 14, 14, 14, 15, 15, //
                                    7,  6,  5,  4,  4,  5,  6,  7,  //
                                    3,  2,  1,  0,  0,  1,  2,  3};
 
+// copy the position along with the history in use (for repetitions)
+void CopyBoard(Board* dest, Board* src) {
+  memcpy(dest, src, offsetof(Board, history));
+  memcpy(dest->history, src->history, src->histPly * sizeof(BoardHistory));
+}
+
 // reset the board to an empty state
 void ClearBoard(Board* board) {
   memset(board->pieces, 0, sizeof(board->pieces));
@@ -285,6 +291,24 @@ inline void SetThreats(Board* board) {
     board->threatenedBy[KNIGHT] |= GetKnightAttacks(PopLSB(&knights));
   board->threatened |= board->threatenedBy[KNIGHT];
 
+#if defined(__AVX2__)
+  // all the sliders at once with vector fills, rather than a table
+  // lookup per piece that may well have fallen out of cache
+  GetSliderAttacksFill(PieceBB(BISHOP, stm),
+                       PieceBB(ROOK, stm),
+                       occ,
+                       &board->threatenedBy[BISHOP],
+                       &board->threatenedBy[ROOK]);
+  board->threatened |= board->threatenedBy[BISHOP] | board->threatenedBy[ROOK];
+
+  board->threatenedBy[QUEEN] = 0;
+  if (PieceBB(QUEEN, stm)) {
+    BitBoard diag, straight;
+    GetSliderAttacksFill(PieceBB(QUEEN, stm), PieceBB(QUEEN, stm), occ, &diag, &straight);
+    board->threatenedBy[QUEEN] = diag | straight;
+  }
+  board->threatened |= board->threatenedBy[QUEEN];
+#else
   board->threatenedBy[BISHOP] = 0;
   BitBoard bishops            = PieceBB(BISHOP, stm);
   while (bishops)
@@ -302,24 +326,23 @@ inline void SetThreats(Board* board) {
   while (queens)
     board->threatenedBy[QUEEN] |= GetQueenAttacks(PopLSB(&queens), occ);
   board->threatened |= board->threatenedBy[QUEEN];
+#endif
 
   board->threatenedBy[KING] = GetKingAttacks(LSB(PieceBB(KING, stm)));
   board->threatened |= board->threatenedBy[KING];
+
+  board->threatsReady = 1;
 }
 
 void MakeMove(Move move, Board* board) {
   MakeMoveUpdate(move, board, 1);
 }
 
-void MakeMoveUpdate(Move move, Board* board, int update) {
-  int from     = From(move);
-  int to       = To(move);
-  int piece    = Moving(move);
-  int captured = IsEP(move) ? Piece(PAWN, board->xstm) : board->squares[to];
-
-  // store hard to recalculate values
-  memcpy(&board->history[board->histPly], board, offsetof(Board, stm));
-  board->history[board->histPly].capture = captured;
+// Plays the move on the position itself, the caller is responsible for
+// saving whatever it needs to get back to where it was
+INLINE void ApplyMove(Move move, Board* board, const int piece, const int captured) {
+  int from = From(move);
+  int to   = To(move);
 
   board->fmr++;
   board->nullply++;
@@ -414,10 +437,24 @@ void MakeMoveUpdate(Move move, Board* board, int update) {
   // special pieces must be loaded after the stm has changed
   // this is because the new stm to move will be the one in check
   SetSpecialPieces(board);
-  SetThreats(board);
+
+  // threats wait until someone asks, plenty of nodes are cut before that
+  board->threatsReady = 0;
+}
+
+void MakeMoveUpdate(Move move, Board* board, int update) {
+  int piece    = Moving(board, move);
+  int captured = IsEP(move) ? Piece(PAWN, board->xstm) : board->squares[To(move)];
+
+  // store hard to recalculate values
+  memcpy(&board->history[board->histPly], board, offsetof(Board, stm));
+  board->history[board->histPly].capture = captured;
+
+  ApplyMove(move, board, piece, captured);
 
   if (update) {
     board->accumulators->move     = move;
+    board->accumulators->moving   = piece;
     board->accumulators->captured = captured;
 
     board->accumulators++;
@@ -425,10 +462,20 @@ void MakeMoveUpdate(Move move, Board* board, int update) {
   }
 }
 
+// Copy-make, the parent position is left untouched so there is nothing to
+// undo. Neither history nor the accumulators are kept, so this is only fit
+// for walking the tree (perft)
+void MakeMoveCopy(Move move, Board* board, Board* next) {
+  int piece    = Moving(board, move);
+  int captured = IsEP(move) ? Piece(PAWN, board->xstm) : board->squares[To(move)];
+
+  memcpy(next, board, offsetof(Board, history));
+  ApplyMove(move, next, piece, captured);
+}
+
 void UndoMove(Move move, Board* board) {
-  int from  = From(move);
-  int to    = To(move);
-  int piece = Moving(move);
+  int from = From(move);
+  int to   = To(move);
 
   board->stm = board->xstm;
   board->xstm ^= 1;
@@ -439,6 +486,8 @@ void UndoMove(Move move, Board* board) {
   // reload historical values
   memcpy(board, &board->history[board->histPly], offsetof(Board, stm));
 
+  int piece = IsPromo(move) ? Piece(PAWN, board->stm) : board->squares[to];
+
   if (IsPromo(move)) {
     int promoted = PromoPiece(move, board->stm);
     FlipBit(board->pieces[piece], to);
@@ -500,7 +549,8 @@ void MakeNullMove(Board* board) {
   board->xstm ^= 1;
 
   SetSpecialPieces(board);
-  SetThreats(board);
+
+  board->threatsReady = 0;
 }
 
 void UndoNullMove(Board* board) {
@@ -570,10 +620,14 @@ inline int IsFiftyMoveRule(Board* board) {
 int IsPseudoLegal(Move move, Board* board) {
   int from   = From(move);
   int to     = To(move);
-  int piece  = Moving(move);
+  int piece  = board->squares[from];
   int pcType = PieceType(piece);
 
-  if (!move || (piece & 1) != board->stm || piece != board->squares[from])
+  if (!move || piece == NO_PIECE || (piece & 1) != board->stm)
+    return 0;
+
+  // the flags have to agree with whatever is sitting on the from square
+  if ((IsCas(move) && pcType != KING) || ((IsPromo(move) || IsEP(move)) && pcType != PAWN))
     return 0;
 
   if (IsCas(move)) {
@@ -593,7 +647,7 @@ int IsPseudoLegal(Move move, Board* board) {
 
     if ((OccBB(BOTH) ^ Bit(from) ^ Bit(board->cr[idx])) & between)
       return 0;
-    if (kingCrossing & board->threatened)
+    if (kingCrossing & Threatened(board))
       return 0;
 
     return 1;
@@ -620,7 +674,7 @@ int IsPseudoLegal(Move move, Board* board) {
     return 0;
   if (GetBit(OccBB(board->stm), to))
     return 0;
-  if (pcType == KING && GetBit(board->threatened, to))
+  if (pcType == KING && GetBit(Threatened(board), to))
     return 0;
 
   if (pcType == PAWN) {
@@ -674,8 +728,10 @@ int IsLegal(Move move, Board* board) {
   return !GetBit(board->pinned, from) || GetBit(PinnedMoves(from, kingSq), to);
 }
 
+#ifndef PREBUILT_TABLES
 uint64_t cuckoo[8192];
 Move cuckooMove[8192];
+#endif
 
 inline uint64_t Hash1(uint64_t hash) {
   return hash & 0x1fff;
@@ -685,6 +741,7 @@ inline uint64_t Hash2(uint64_t hash) {
   return (hash >> 16) & 0x1fff;
 }
 
+#ifndef PREBUILT_TABLES
 void InitCuckoo() {
   int validate = 0;
 
@@ -698,7 +755,7 @@ void InitCuckoo() {
         if (!GetBit(GetPieceAttacks(s1, 0, pcType), s2))
           continue;
 
-        Move move     = BuildMove(s1, s2, pc, QUIET_FLAG);
+        Move move     = BuildMove(s1, s2, QUIET_FLAG);
         uint64_t hash = ZOBRIST_PIECES[pc][s1] ^ ZOBRIST_PIECES[pc][s2] ^ ZOBRIST_SIDE_KEY;
 
         uint32_t i = Hash1(hash);
@@ -725,6 +782,7 @@ void InitCuckoo() {
   if (validate != 3668)
     printf("Failed to set cuckoo tables.\n"), exit(1);
 }
+#endif
 
 // Upcoming repetition detection
 // http://www.open-chess.org/viewtopic.php?f=5&t=2300
@@ -37,6 +37,10 @@
 
 extern const uint16_t KING_BUCKETS[64];
 
+extern TABLE uint64_t cuckoo[8192];
+extern TABLE Move cuckooMove[8192];
+
+void CopyBoard(Board* dest, Board* src);
 void ClearBoard(Board* board);
 void ParseFen(char* fen, Board* board);
 void BoardToFen(char* fen, Board* board);
@@ -56,6 +60,7 @@ void MakeNullMove(Board* board);
 void UndoNullMove(Board* board);
 void MakeMove(Move move, Board* board);
 void MakeMoveUpdate(Move move, Board* board, int update);
+void MakeMoveCopy(Move move, Board* board, Board* next);
 void UndoMove(Move move, Board* board);
 
 int IsPseudoLegal(Move move, Board* board);
@@ -64,15 +69,29 @@ int IsLegal(Move move, Board* board);
 void InitCuckoo();
 int HasCycle(Board* board, int ply);
 
+INLINE BitBoard Threatened(Board* board) {
+  if (!board->threatsReady)
+    SetThreats(board);
+
+  return board->threatened;
+}
+
+INLINE BitBoard ThreatenedBy(Board* board, const int pt) {
+  if (!board->threatsReady)
+    SetThreats(board);
+
+  return board->threatenedBy[pt];
+}
+
 INLINE BitBoard OpponentsEasyCaptures(Board* board) {
   const int stm         = board->stm;
   const BitBoard queens = PieceBB(QUEEN, stm);
   const BitBoard rooks  = queens | PieceBB(ROOK, stm);
   const BitBoard minors = rooks | PieceBB(BISHOP, stm) | PieceBB(KNIGHT, stm);
 
-  const BitBoard pawnThreats  = board->threatenedBy[PAWN];
-  const BitBoard minorThreats = pawnThreats | board->threatenedBy[KNIGHT] | board->threatenedBy[BISHOP];
-  const BitBoard rookThreats  = minorThreats | board->threatenedBy[ROOK];
+  const BitBoard pawnThreats  = ThreatenedBy(board, PAWN);
+  const BitBoard minorThreats = pawnThreats | ThreatenedBy(board, KNIGHT) | ThreatenedBy(board, BISHOP);
+  const BitBoard rookThreats  = minorThreats | ThreatenedBy(board, ROOK);
 
   return (queens & rookThreats) | (rooks & minorThreats) | (minors & pawnThreats);
 }
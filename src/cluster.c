@@ -0,0 +1,856 @@
+// Berserk is a UCI compliant chess engine written in C
+// Copyright (C) 2024 Jay Honnold
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "cluster.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "board.h"
+#include "move.h"
+#include "search.h"
+#include "thread.h"
+#include "transposition.h"
+#include "uci.h"
+#include "util.h"
+
+// A cluster is one coordinator, the engine the GUI talks to, and any number
+// of worker processes connected to it over a stream socket. Every process
+// runs its own Lazy SMP search of the same position and the deeper TT
+// entries are passed around in batches, workers sending theirs to the
+// coordinator which forwards them to the rest. Once the coordinator stops,
+// the deepest root result of any process is played.
+ClusterState Cluster;
+
+#if defined(_WIN32)
+
+int ClusterListen(char* address) {
+  (void) address;
+  printf("info string cluster mode is not supported on this platform\n");
+  return 0;
+}
+
+void ClusterWorker(char* address, int threads, int hash) {
+  (void) threads;
+  (void) hash;
+  ClusterListen(address);
+}
+
+int ClusterPeers() {
+  return 0;
+}
+
+void ClusterUsePeers(int n) {
+  (void) n;
+}
+
+void ClusterSetPosition(char* position, uint64_t key) {
+  (void) position;
+  (void) key;
+}
+
+void ClusterNewGame() {}
+
+void ClusterExit() {}
+
+void ClusterStartSearch(Board* board) {
+  (void) board;
+}
+
+void ClusterStopSearch() {}
+
+void ClusterFinishSearch(ThreadData* thread, Move* bestMove, Move* ponderMove) {
+  (void) thread;
+  (void) bestMove;
+  (void) ponderMove;
+}
+
+void ClusterShareTT(uint64_t hash, int depth, int score, int bound, Move move, int ply, int eval) {
+  (void) hash;
+  (void) depth;
+  (void) score;
+  (void) bound;
+  (void) move;
+  (void) ply;
+  (void) eval;
+}
+
+#else
+
+#define CLUSTER_MAGIC   0x42455253 // "BERS"
+#define MAX_MESSAGE     16384
+#define RESULT_WAIT_MS  1000 // for results of searches without a clock
+#define RESULT_LATE_MS  5    // past the hard limit, when it is already spent
+#define CONNECT_TRIES   300 // 100ms apart
+#define POSITION_LENGTH 8192
+#define OUTBOX_SIZE     (1 << 18) // bytes queued for a peer, TT batches are dropped beyond it
+#define OUTBOX_RESERVE  (1 << 14) // left to other messages when TT batches are dropped
+
+enum {
+  MSG_HELLO,
+  MSG_POSITION,
+  MSG_GO,
+  MSG_STOP,
+  MSG_NEWGAME,
+  MSG_TT,
+  MSG_RESULT,
+  MSG_SETTINGS
+};
+
+typedef struct {
+  uint32_t type;
+  uint32_t size; // of the payload that follows
+} MessageHeader;
+
+// Processes exchange raw structs, so every one must run the same build
+typedef struct {
+  uint32_t magic;
+  uint32_t entrySize;
+} Hello;
+
+typedef struct {
+  uint64_t key; // of the root it was searched from
+  uint32_t id;  // of the go it answers
+  int32_t depth, score;
+  Move move, ponder;
+} SearchResult;
+
+// Options that change what a search plays, sent to workers ahead of every go
+typedef struct {
+  int32_t chess960, contempt;
+} Settings;
+
+// Messages to a peer are queued in its outbox and written by a sender
+// thread of its own, so a peer that stops reading never blocks a search
+typedef struct {
+  int fd;
+  int used;    // slot taken by a connection
+  int alive;   // said hello and is still connected
+  int pending; // searching for the coordinator, result not yet in
+  SearchResult result;
+  pthread_mutex_t sendLock;
+  pthread_cond_t sendReady;
+  pthread_t sender;
+  char* outbox;      // ring of OUTBOX_SIZE bytes
+  size_t head, tail; // bytes ever queued and written
+  int closing;
+} Peer;
+
+static Peer peers[CLUSTER_MAX_PEERS];
+static Peer coordinator; // a worker's only connection
+static int usePeers = CLUSTER_MAX_PEERS;
+static uint32_t searchId;
+
+static pthread_mutex_t peersLock   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t resultsReady = PTHREAD_COND_INITIALIZER;
+static int listenFd                = -1;
+static char socketPath[sizeof(((struct sockaddr_un*) 0)->sun_path)]; // removed on exit
+
+// The last position the GUI set, sent to workers ahead of every go
+static char position[POSITION_LENGTH];
+static uint64_t positionKey;
+
+static pthread_mutex_t batchLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Held by peer threads while they write received entries into the TT, and
+// to end sharing, so no late batch outlives the search into a TT reallocation
+static pthread_mutex_t storeLock = PTHREAD_MUTEX_INITIALIZER;
+static ClusterTTEntry batch[CLUSTER_BATCH];
+static int batchCount;
+static long batchStart;
+
+// "host:port" (an empty host listens everywhere) is TCP, a path without a
+// colon a unix socket. Returns a listening or connected socket, -1 on error
+static int OpenSocket(char* address, int server) {
+  char* colon = strrchr(address, ':');
+  int fd      = -1;
+
+  if (colon == NULL) {
+    struct sockaddr_un addr = {0};
+    addr.sun_family         = AF_UNIX;
+    if (strlen(address) >= sizeof(addr.sun_path))
+      return -1;
+    strcpy(addr.sun_path, address);
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+      return -1;
+
+    // Only a socket left behind by an earlier run is replaced
+    struct stat st;
+    if (server && !lstat(address, &st)) {
+      if (!S_ISSOCK(st.st_mode)) {
+        close(fd);
+        return -1;
+      }
+
+      unlink(address);
+    }
+
+    struct sockaddr* sa = (struct sockaddr*) &addr;
+    if (server ? bind(fd, sa, sizeof(addr)) || listen(fd, CLUSTER_MAX_PEERS) : connect(fd, sa, sizeof(addr)))
+      close(fd), fd = -1;
+
+    return fd;
+  }
+
+  char host[256];
+  snprintf(host, sizeof(host), "%.*s", (int) (colon - address), address);
+
+  struct addrinfo hints = {0}, *res;
+  hints.ai_family       = AF_UNSPEC;
+  hints.ai_socktype     = SOCK_STREAM;
+  hints.ai_flags        = server ? AI_PASSIVE : 0;
+
+  if (getaddrinfo(*host ? host : NULL, colon + 1, &hints, &res))
+    return -1;
+
+  for (struct addrinfo* ai = res; ai != NULL && fd < 0; ai = ai->ai_next) {
+    if ((fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0)
+      continue;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (server ? bind(fd, ai->ai_addr, ai->ai_addrlen) || listen(fd, CLUSTER_MAX_PEERS)
+               : connect(fd, ai->ai_addr, ai->ai_addrlen))
+      close(fd), fd = -1;
+  }
+
+  freeaddrinfo(res);
+  return fd;
+}
+
+static int ReadAll(int fd, void* buf, size_t size) {
+  char* p = buf;
+
+  while (size) {
+    ssize_t n = read(fd, p, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return 0;
+
+    p += n, size -= n;
+  }
+
+  return 1;
+}
+
+static int WriteAll(int fd, const void* buf, size_t size) {
+  const char* p = buf;
+
+  while (size) {
+    ssize_t n = write(fd, p, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return 0;
+
+    p += n, size -= n;
+  }
+
+  return 1;
+}
+
+static void OutboxWrite(Peer* peer, const void* data, size_t size) {
+  const char* p = data;
+
+  while (size) {
+    size_t at = peer->head % OUTBOX_SIZE;
+    size_t n  = Min(size, OUTBOX_SIZE - at);
+
+    memcpy(peer->outbox + at, p, n);
+    peer->head += n;
+    p += n, size -= n;
+  }
+}
+
+// Queues a message and returns at once. A TT batch that doesn't fit is
+// dropped, anything else means the peer stopped reading long ago and the
+// connection is dropped instead (its reader notices the shutdown)
+static void Send(Peer* peer, int type, const void* data, size_t size) {
+  MessageHeader header = {type, size};
+  size_t limit         = OUTBOX_SIZE - (type == MSG_TT ? OUTBOX_RESERVE : 0);
+
+  pthread_mutex_lock(&peer->sendLock);
+  if (peer->outbox && !peer->closing) {
+    if (peer->head - peer->tail + sizeof(header) + size <= limit) {
+      OutboxWrite(peer, &header, sizeof(header));
+      OutboxWrite(peer, data, size);
+      pthread_cond_signal(&peer->sendReady);
+    } else if (type != MSG_TT)
+      shutdown(peer->fd, SHUT_RDWR);
+  }
+  pthread_mutex_unlock(&peer->sendLock);
+}
+
+static void* SendLoop(void* arg) {
+  Peer* peer = arg;
+
+  pthread_mutex_lock(&peer->sendLock);
+  while (1) {
+    while (peer->head == peer->tail && !peer->closing)
+      pthread_cond_wait(&peer->sendReady, &peer->sendLock);
+
+    if (peer->closing)
+      break;
+
+    size_t at = peer->tail % OUTBOX_SIZE;
+    size_t n  = Min(peer->head - peer->tail, OUTBOX_SIZE - at);
+
+    pthread_mutex_unlock(&peer->sendLock);
+    int written = WriteAll(peer->fd, peer->outbox + at, n);
+    pthread_mutex_lock(&peer->sendLock);
+
+    peer->tail += n;
+    if (!written) {
+      shutdown(peer->fd, SHUT_RDWR);
+      peer->tail = peer->head;
+    }
+  }
+  pthread_mutex_unlock(&peer->sendLock);
+
+  return NULL;
+}
+
+static int PeerOpen(Peer* peer, int fd) {
+  peer->fd      = fd;
+  peer->head    = peer->tail = 0;
+  peer->closing = 0;
+
+  if ((peer->outbox = malloc(OUTBOX_SIZE)) == NULL)
+    return 0;
+
+  if (pthread_create(&peer->sender, NULL, SendLoop, peer)) {
+    free(peer->outbox);
+    peer->outbox = NULL;
+    return 0;
+  }
+
+  return 1;
+}
+
+static void PeerClose(Peer* peer) {
+  pthread_mutex_lock(&peer->sendLock);
+  peer->closing = 1;
+  pthread_cond_signal(&peer->sendReady);
+  pthread_mutex_unlock(&peer->sendLock);
+
+  shutdown(peer->fd, SHUT_RDWR); // releases a write blocked on a full socket
+  pthread_join(peer->sender, NULL);
+
+  pthread_mutex_lock(&peer->sendLock);
+  close(peer->fd);
+  peer->fd = -1;
+  free(peer->outbox);
+  peer->outbox = NULL;
+  pthread_mutex_unlock(&peer->sendLock);
+}
+
+// Reads one message into data, which is left null terminated for text
+static int Receive(int fd, MessageHeader* header, char* data) {
+  if (!ReadAll(fd, header, sizeof(MessageHeader)) || header->size > MAX_MESSAGE)
+    return 0;
+
+  if (!ReadAll(fd, data, header->size))
+    return 0;
+
+  data[header->size] = '\0';
+  return 1;
+}
+
+// Entries only replace shallower ones, they are hints for the local search
+static void StoreTT(ClusterTTEntry* entries, int count) {
+  for (int i = 0; i < count; i++) {
+    ClusterTTEntry* e = &entries[i];
+
+    int hit = 0, ttScore, ttEval, ttDepth, ttBound, ttPv = 0;
+    Move ttMove = NULL_MOVE;
+
+    TTEntry* tt = TTProbe(e->hash, 0, &hit, &ttMove, &ttScore, &ttEval, &ttDepth, &ttBound, &ttPv);
+    if (!hit || ttDepth < e->depth)
+      TTPut(tt, e->hash, e->depth, e->score, e->bound, e->move, 0, e->eval, 0);
+  }
+}
+
+// Forward to every peer still searching, except the one it came from
+static void Broadcast(Peer* from, int type, const void* data, size_t size) {
+  for (int i = 0; i < CLUSTER_MAX_PEERS; i++)
+    if (&peers[i] != from && peers[i].pending)
+      Send(&peers[i], type, data, size);
+}
+
+static void* PeerLoop(void* arg) {
+  Peer* peer = arg;
+  int id     = (int) (peer - peers) + 1;
+
+  MessageHeader header;
+  uint64_t buf[MAX_MESSAGE / sizeof(uint64_t) + 1];
+  char* data = (char*) buf;
+
+  Hello* hello = (Hello*) data;
+  if (Receive(peer->fd, &header, data) && header.type == MSG_HELLO && header.size == sizeof(Hello) &&
+      hello->magic == CLUSTER_MAGIC && hello->entrySize == sizeof(ClusterTTEntry)) {
+    peer->alive = 1;
+    printf("info string cluster peer %d connected\n", id);
+
+    while (Receive(peer->fd, &header, data)) {
+      if (header.type == MSG_TT) {
+        pthread_mutex_lock(&storeLock);
+        if (Cluster.sharing)
+          StoreTT((ClusterTTEntry*) data, header.size / sizeof(ClusterTTEntry));
+        pthread_mutex_unlock(&storeLock);
+
+        Broadcast(peer, MSG_TT, data, header.size);
+      } else if (header.type == MSG_RESULT && header.size == sizeof(SearchResult)) {
+        pthread_mutex_lock(&peersLock);
+        memcpy(&peer->result, data, sizeof(SearchResult));
+        if (peer->result.id == searchId)
+          peer->pending = 0;
+        pthread_cond_broadcast(&resultsReady);
+        pthread_mutex_unlock(&peersLock);
+      }
+    }
+
+    printf("info string cluster peer %d disconnected\n", id);
+  }
+
+  PeerClose(peer);
+
+  pthread_mutex_lock(&peersLock);
+  peer->alive = peer->pending = peer->used = 0;
+  pthread_cond_broadcast(&resultsReady);
+  pthread_mutex_unlock(&peersLock);
+
+  return NULL;
+}
+
+static void* AcceptLoop(void* arg) {
+  (void) arg;
+
+  while (1) {
+    int fd = accept(listenFd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      break;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    Peer* peer = NULL;
+    pthread_mutex_lock(&peersLock);
+    for (int i = 0; i < CLUSTER_MAX_PEERS && peer == NULL; i++)
+      if (!peers[i].used)
+        peer = &peers[i];
+
+    if (peer) {
+      peer->used = 1;
+      peer->fd   = fd;
+    }
+    pthread_mutex_unlock(&peersLock);
+
+    pthread_t thread;
+    if (peer == NULL || !PeerOpen(peer, fd)) {
+      close(fd);
+      if (peer)
+        peer->fd = -1, peer->used = 0;
+      continue;
+    }
+
+    if (pthread_create(&thread, NULL, PeerLoop, peer)) {
+      PeerClose(peer);
+      peer->used = 0;
+      continue;
+    }
+
+    pthread_detach(thread);
+  }
+
+  return NULL;
+}
+
+static void SendTT(ClusterTTEntry* entries, int count) {
+  if (Cluster.role == CLUSTER_WORKER)
+    Send(&coordinator, MSG_TT, entries, count * sizeof(ClusterTTEntry));
+  else
+    Broadcast(NULL, MSG_TT, entries, count * sizeof(ClusterTTEntry));
+}
+
+// Sends the partial batch if it has been held back for at least minAge
+static void FlushBatch(long minAge) {
+  ClusterTTEntry out[CLUSTER_BATCH];
+  int count = 0;
+
+  pthread_mutex_lock(&batchLock);
+  if (batchCount && GetTimeMS() - batchStart >= minAge) {
+    count = batchCount;
+    memcpy(out, batch, count * sizeof(ClusterTTEntry));
+    batchCount = 0;
+  }
+  pthread_mutex_unlock(&batchLock);
+
+  if (count)
+    SendTT(out, count);
+}
+
+// A search that writes few deep entries would otherwise keep them to itself
+static void* FlushLoop(void* arg) {
+  (void) arg;
+
+  while (1) {
+    usleep(CLUSTER_FLUSH_MS * 1000 / 2);
+    if (Cluster.sharing)
+      FlushBatch(CLUSTER_FLUSH_MS / 2);
+  }
+
+  return NULL;
+}
+
+static int StartFlushing() {
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, FlushLoop, NULL))
+    return 0;
+
+  pthread_detach(thread);
+  return 1;
+}
+
+int ClusterListen(char* address) {
+  if (Cluster.role != CLUSTER_OFF) {
+    printf("info string cluster is already running\n");
+    return 0;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+
+  if ((listenFd = OpenSocket(address, 1)) < 0)
+    return 0;
+
+  for (int i = 0; i < CLUSTER_MAX_PEERS; i++) {
+    peers[i].fd = -1;
+    pthread_mutex_init(&peers[i].sendLock, NULL);
+    pthread_cond_init(&peers[i].sendReady, NULL);
+  }
+
+  pthread_t thread;
+  if (!StartFlushing() || pthread_create(&thread, NULL, AcceptLoop, NULL)) {
+    close(listenFd);
+    return 0;
+  }
+
+  pthread_detach(thread);
+  Cluster.role = CLUSTER_COORDINATOR;
+
+  if (strrchr(address, ':') == NULL)
+    strcpy(socketPath, address);
+
+  return 1;
+}
+
+void ClusterExit() {
+  if (Cluster.role != CLUSTER_COORDINATOR)
+    return;
+
+  close(listenFd);
+  if (socketPath[0])
+    unlink(socketPath);
+}
+
+int ClusterPeers() {
+  int count = 0;
+  for (int i = 0; i < CLUSTER_MAX_PEERS; i++)
+    count += peers[i].alive;
+
+  return count;
+}
+
+// Limit searches to the first n connected workers, all of them when negative
+void ClusterUsePeers(int n) {
+  usePeers = n < 0 ? CLUSTER_MAX_PEERS : n;
+}
+
+// Workers only join a search of the position last set here, anything else
+// (bench, or a position the GUI never sent) is searched locally
+void ClusterSetPosition(char* text, uint64_t key) {
+  snprintf(position, sizeof(position), "%s", text);
+  positionKey = key;
+}
+
+void ClusterNewGame() {
+  if (Cluster.role != CLUSTER_COORDINATOR)
+    return;
+
+  for (int i = 0; i < CLUSTER_MAX_PEERS; i++)
+    if (peers[i].alive)
+      Send(&peers[i], MSG_NEWGAME, NULL, 0);
+}
+
+void ClusterStartSearch(Board* board) {
+  pthread_mutex_lock(&batchLock);
+  batchCount = 0;
+  pthread_mutex_unlock(&batchLock);
+
+  if (Cluster.role == CLUSTER_WORKER) {
+    Cluster.sharing = 1;
+    return;
+  }
+
+  Cluster.sharing = 0;
+  if (Cluster.role != CLUSTER_COORDINATOR || board->zobrist != positionKey || Limits.multiPV > 1 ||
+      Limits.searchMoves)
+    return;
+
+  pthread_mutex_lock(&peersLock);
+  searchId++;
+  for (int i = 0, n = 0; i < CLUSTER_MAX_PEERS; i++) {
+    peers[i].pending = peers[i].alive && n < usePeers;
+    n += peers[i].pending;
+    Cluster.sharing |= peers[i].pending;
+  }
+  pthread_mutex_unlock(&peersLock);
+
+  Settings settings = {CHESS_960, CONTEMPT};
+  for (int i = 0; i < CLUSTER_MAX_PEERS; i++) {
+    if (!peers[i].pending)
+      continue;
+
+    Send(&peers[i], MSG_SETTINGS, &settings, sizeof(settings));
+    Send(&peers[i], MSG_POSITION, position, strlen(position) + 1);
+    Send(&peers[i], MSG_GO, &searchId, sizeof(searchId));
+  }
+}
+
+void ClusterStopSearch() {
+  if (Cluster.role != CLUSTER_COORDINATOR || !Cluster.sharing)
+    return;
+
+  for (int i = 0; i < CLUSTER_MAX_PEERS; i++)
+    if (peers[i].pending)
+      Send(&peers[i], MSG_STOP, NULL, 0);
+}
+
+// Called for TT writes at CLUSTER_TT_DEPTH and deeper, which are rare enough
+// that a shared batch behind a lock costs nothing measurable
+void ClusterShareTT(uint64_t hash, int depth, int score, int bound, Move move, int ply, int eval) {
+  // Mate scores are sent relative to the node, as the TT stores them
+  if (score >= TB_WIN_BOUND)
+    score += ply;
+  else if (score <= -TB_WIN_BOUND)
+    score -= ply;
+
+  ClusterTTEntry out[CLUSTER_BATCH];
+  int count = 0;
+
+  pthread_mutex_lock(&batchLock);
+  if (!batchCount)
+    batchStart = GetTimeMS();
+
+  batch[batchCount++] = (ClusterTTEntry) {hash, score, eval, move, depth, bound};
+
+  if (batchCount == CLUSTER_BATCH) {
+    count = batchCount;
+    memcpy(out, batch, count * sizeof(ClusterTTEntry));
+    batchCount = 0;
+  }
+  pthread_mutex_unlock(&batchLock);
+
+  if (count)
+    SendTT(out, count);
+}
+
+// Workers report their result, the coordinator waits for those and plays
+// the deepest completed iteration of any process
+void ClusterFinishSearch(ThreadData* thread, Move* bestMove, Move* ponderMove) {
+  Board* board = &thread->board;
+
+  // Every search thread is done, so the last entries go out ahead of the result
+  if (Cluster.sharing)
+    FlushBatch(0);
+
+  if (Cluster.role == CLUSTER_WORKER) {
+    Cluster.sharing = 0;
+
+    SearchResult result = {board->zobrist,           searchId,  thread->rootMoves[0].depth,
+                           thread->rootMoves[0].score, *bestMove, *ponderMove};
+    Send(&coordinator, MSG_RESULT, &result, sizeof(result));
+    return;
+  }
+
+  if (Cluster.role != CLUSTER_COORDINATOR || !Cluster.sharing)
+    return;
+
+  // On the clock, results are only waited for until the hard limit. Past
+  // it the local result is played unless one arrives right away
+  long wait = RESULT_WAIT_MS;
+  if (Limits.timeset)
+    wait = Min(wait, Max(RESULT_LATE_MS, Limits.start + Limits.max - GetTimeMS()));
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += wait / 1000;
+  deadline.tv_nsec += (wait % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L)
+    deadline.tv_sec++, deadline.tv_nsec -= 1000000000L;
+
+  pthread_mutex_lock(&peersLock);
+  while (1) {
+    int pending = 0;
+    for (int i = 0; i < CLUSTER_MAX_PEERS; i++)
+      pending += peers[i].pending;
+
+    if (!pending || pthread_cond_timedwait(&resultsReady, &peersLock, &deadline))
+      break;
+  }
+
+  // Entries sent ahead of the results are in, nothing is stored past here
+  pthread_mutex_lock(&storeLock);
+  Cluster.sharing = 0;
+  pthread_mutex_unlock(&storeLock);
+
+  int bestDepth = thread->rootMoves[0].depth;
+  int bestScore = thread->rootMoves[0].score;
+  int bestPeer  = 0;
+
+  for (int i = 0; i < CLUSTER_MAX_PEERS; i++) {
+    SearchResult* r = &peers[i].result;
+    if (!peers[i].alive || peers[i].pending || r->id != searchId || r->key != board->zobrist || !r->move)
+      continue;
+
+    // Same rule as thread voting for mates, otherwise the deeper search wins
+    int deeper = r->depth > bestDepth || (r->depth == bestDepth && r->score > bestScore);
+    int better = abs(bestScore) >= TB_WIN_BOUND ? r->score > bestScore : r->score > -TB_WIN_BOUND && deeper;
+
+    if (better && IsPseudoLegal(r->move, board) && IsLegal(r->move, board))
+      bestDepth = r->depth, bestScore = r->score, bestPeer = i + 1;
+  }
+
+  for (int i = 0; i < CLUSTER_MAX_PEERS; i++)
+    peers[i].pending = 0;
+
+  if (bestPeer) {
+    *bestMove   = peers[bestPeer - 1].result.move;
+    *ponderMove = peers[bestPeer - 1].result.ponder;
+    printf("info string cluster peer %d depth %d score %d\n", bestPeer, bestDepth, bestScore);
+  }
+  pthread_mutex_unlock(&peersLock);
+}
+
+// A worker searches whatever the coordinator sends until it disconnects
+void ClusterWorker(char* address, int threads, int hash) {
+  signal(SIGPIPE, SIG_IGN);
+
+  // The coordinator may not be listening yet
+  int fd = OpenSocket(address, 0);
+  for (int i = 0; fd < 0 && i < CONNECT_TRIES; i++) {
+    usleep(100000);
+    fd = OpenSocket(address, 0);
+  }
+
+  if (fd < 0) {
+    printf("info string cluster could not connect to %s\n", address);
+    return;
+  }
+
+  pthread_mutex_init(&coordinator.sendLock, NULL);
+  pthread_cond_init(&coordinator.sendReady, NULL);
+  if (!StartFlushing() || !PeerOpen(&coordinator, fd)) {
+    close(fd);
+    return;
+  }
+
+  Cluster.role = CLUSTER_WORKER;
+
+  ThreadsSetNumber(Max(1, Min(2048, threads)));
+  TTInit(Max(2, Min(HASH_MAX, hash)));
+
+  Hello hello = {CLUSTER_MAGIC, sizeof(ClusterTTEntry)};
+  Send(&coordinator, MSG_HELLO, &hello, sizeof(hello));
+  printf("info string cluster connected to %s\n", address);
+
+  Board board;
+  ParsePosition("position startpos", &board);
+
+  Threads.searching = Threads.sleeping = 0;
+
+  MessageHeader header;
+  uint64_t buf[MAX_MESSAGE / sizeof(uint64_t) + 1];
+  char* data = (char*) buf;
+
+  while (Receive(fd, &header, data)) {
+    if (header.type == MSG_SETTINGS && header.size == sizeof(Settings)) {
+      Settings* settings = (Settings*) data;
+      CHESS_960          = settings->chess960;
+      CONTEMPT           = settings->contempt;
+    } else if (header.type == MSG_POSITION) {
+      ParsePosition(data, &board);
+    } else if (header.type == MSG_GO && header.size == sizeof(uint32_t)) {
+      memcpy(&searchId, data, sizeof(uint32_t));
+
+      // Searches until told to stop, the coordinator keeps the time
+      Limits.start        = GetTimeMS();
+      Limits.timeset      = 0;
+      Limits.max          = INT_MAX;
+      Limits.depth        = MAX_SEARCH_PLY - 1;
+      Limits.mate         = 0;
+      Limits.nodes        = 0;
+      Limits.hitrate      = 1000;
+      Limits.multiPV      = 1;
+      Limits.splitMultiPV = 0;
+      Limits.searchMoves  = 0;
+      Limits.infinite     = 1;
+
+      StartSearch(&board, 0);
+    } else if (header.type == MSG_STOP) {
+      StopSearch();
+    } else if (header.type == MSG_NEWGAME) {
+      if (Threads.searching)
+        ThreadWaitUntilSleep(Threads.threads[0]);
+      NewGameClear();
+    } else if (header.type == MSG_TT) {
+      StoreTT((ClusterTTEntry*) data, header.size / sizeof(ClusterTTEntry));
+    }
+  }
+
+  StopSearch();
+  if (Threads.searching)
+    ThreadWaitUntilSleep(Threads.threads[0]);
+
+  PeerClose(&coordinator);
+  pthread_mutex_destroy(&Threads.lock);
+  ThreadsExit();
+}
+
+#endif
@@ -0,0 +1,59 @@
+// Berserk is a UCI compliant chess engine written in C
+// Copyright (C) 2024 Jay Honnold
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include "types.h"
+
+#define CLUSTER_MAX_PEERS 64
+#define CLUSTER_TT_DEPTH  8  // shallowest TT entries sent to other processes
+#define CLUSTER_BATCH     64 // TT entries per message
+#define CLUSTER_FLUSH_MS  20 // longest a partial batch is held back
+
+enum {
+  CLUSTER_OFF,
+  CLUSTER_COORDINATOR,
+  CLUSTER_WORKER
+};
+
+typedef struct {
+  uint64_t hash;
+  int16_t score, eval;
+  Move move;
+  uint8_t depth, bound;
+} ClusterTTEntry;
+
+typedef struct {
+  int role;
+  int sharing; // a search is running with other processes, TT entries are sent out
+} ClusterState;
+
+extern ClusterState Cluster;
+
+int ClusterListen(char* address);
+void ClusterWorker(char* address, int threads, int hash);
+int ClusterPeers();
+void ClusterUsePeers(int n);
+void ClusterSetPosition(char* position, uint64_t key);
+void ClusterNewGame();
+void ClusterExit();
+void ClusterStartSearch(Board* board);
+void ClusterStopSearch();
+void ClusterFinishSearch(ThreadData* thread, Move* bestMove, Move* ponderMove);
+void ClusterShareTT(uint64_t hash, int depth, int score, int bound, Move move, int ply, int eval);
+
+#endif
@@ -0,0 +1,135 @@
+// Berserk is a UCI compliant chess engine written in C
+// Copyright (C) 2024 Jay Honnold
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "gentables.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "attacks.h"
+#include "board.h"
+#include "nn/evaluate.h"
+#include "search.h"
+#include "types.h"
+#include "zobrist.h"
+
+enum {
+  T_U64,
+  T_U16,
+  T_INT
+};
+
+static const size_t TYPE_SIZE[] = {sizeof(uint64_t), sizeof(uint16_t), sizeof(int)};
+
+static void WriteValues(FILE* fout, const void* data, int n, int type) {
+  for (int i = 0; i < n; i++) {
+    if (i && !(i % 8))
+      fprintf(fout, "\n   ");
+
+    if (type == T_U64)
+      fprintf(fout, "0x%016" PRIx64 "ull", ((const uint64_t*) data)[i]);
+    else if (type == T_U16)
+      fprintf(fout, "%d", ((const uint16_t*) data)[i]);
+    else
+      fprintf(fout, "%d", ((const int*) data)[i]);
+
+    if (i < n - 1)
+      fprintf(fout, ", ");
+  }
+}
+
+// Write a flat (rows = 0) or 2d table as an initialized definition
+static void WriteTable(FILE* fout, const char* decl, const void* data, int rows, int cols, int type) {
+  fprintf(fout, "%s = {", decl);
+
+  if (!rows) {
+    WriteValues(fout, data, cols, type);
+  } else {
+    for (int r = 0; r < rows; r++) {
+      fprintf(fout, "\n  {");
+      WriteValues(fout, (const char*) data + r * cols * TYPE_SIZE[type], cols, type);
+      fprintf(fout, r < rows - 1 ? "}," : "}");
+    }
+  }
+
+  fprintf(fout, "};\n\n");
+}
+
+// Dump every table built at startup, along with the permuted network,
+// so a PREBUILT build can compile them in and skip the work entirely
+int GenerateTables(char* tablesPath, char* networkPath) {
+  FILE* fout = fopen(tablesPath, "w");
+  if (fout == NULL) {
+    printf("Unable to write file at %s\n", tablesPath);
+    return 0;
+  }
+
+  fprintf(fout, "// Generated by `make tables`, do not edit\n\n");
+  fprintf(fout, "#include \"attacks.h\"\n");
+  fprintf(fout, "#include \"board.h\"\n");
+  fprintf(fout, "#include \"gentables.h\"\n");
+  fprintf(fout, "#include \"nn/evaluate.h\"\n");
+  fprintf(fout, "#include \"search.h\"\n");
+  fprintf(fout, "#include \"types.h\"\n");
+  fprintf(fout, "#include \"zobrist.h\"\n\n");
+
+  fprintf(fout, "#if TABLES_ARCH != %d\n", TABLES_ARCH);
+  fprintf(fout, "#error \"%s was generated for a different ARCH, run make tables again\"\n", tablesPath);
+  fprintf(fout, "#endif\n\n");
+
+  WriteTable(fout, "const uint64_t ZOBRIST_PIECES[12][64]", ZOBRIST_PIECES, 12, 64, T_U64);
+  WriteTable(fout, "const uint64_t ZOBRIST_EP_KEYS[64]", ZOBRIST_EP_KEYS, 0, 64, T_U64);
+  WriteTable(fout, "const uint64_t ZOBRIST_CASTLE_KEYS[16]", ZOBRIST_CASTLE_KEYS, 0, 16, T_U64);
+  fprintf(fout, "const uint64_t ZOBRIST_SIDE_KEY = 0x%016" PRIx64 "ull;\n\n", ZOBRIST_SIDE_KEY);
+
+  WriteTable(fout, "const int LMR[MAX_SEARCH_PLY][64]", LMR, MAX_SEARCH_PLY, 64, T_INT);
+  WriteTable(fout, "const int LMP[2][MAX_SEARCH_PLY]", LMP, 2, MAX_SEARCH_PLY, T_INT);
+  WriteTable(fout, "const int STATIC_PRUNE[2][MAX_SEARCH_PLY]", STATIC_PRUNE, 2, MAX_SEARCH_PLY, T_INT);
+
+  WriteTable(fout, "const BitBoard BETWEEN_SQS[64][64]", BETWEEN_SQS, 64, 64, T_U64);
+  WriteTable(fout, "const BitBoard PINNED_MOVES[64][64]", PINNED_MOVES, 64, 64, T_U64);
+  WriteTable(fout, "const BitBoard PAWN_ATTACKS[2][64]", PAWN_ATTACKS, 2, 64, T_U64);
+  WriteTable(fout, "const BitBoard KNIGHT_ATTACKS[64]", KNIGHT_ATTACKS, 0, 64, T_U64);
+  WriteTable(fout, "const BitBoard KING_ATTACKS[64]", KING_ATTACKS, 0, 64, T_U64);
+  WriteTable(fout, "const BitBoard ROOK_MASKS[64]", ROOK_MASKS, 0, 64, T_U64);
+  WriteTable(fout, "const BitBoard BISHOP_MASKS[64]", BISHOP_MASKS, 0, 64, T_U64);
+  WriteTable(fout,
+             "const BitBoard SLIDER_ATTACKS[BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE]",
+             SLIDER_ATTACKS,
+             0,
+             BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE,
+             T_U64);
+
+  // The per square slider tables are offsets into the shared one
+  fprintf(fout, "const BitBoard* const BISHOP_ATTACKS[64] = {");
+  for (int sq = 0; sq < 64; sq++)
+    fprintf(fout, "%sSLIDER_ATTACKS + %d", sq ? ",\n  " : "", (int) (BISHOP_ATTACKS[sq] - SLIDER_ATTACKS));
+  fprintf(fout, "};\n\n");
+
+  fprintf(fout, "const BitBoard* const ROOK_ATTACKS[64] = {");
+  for (int sq = 0; sq < 64; sq++)
+    fprintf(fout, "%sSLIDER_ATTACKS + %d", sq ? ",\n  " : "", (int) (ROOK_ATTACKS[sq] - SLIDER_ATTACKS));
+  fprintf(fout, "};\n\n");
+
+  WriteTable(fout, "const uint64_t cuckoo[8192]", cuckoo, 0, 8192, T_U64);
+  WriteTable(fout, "const Move cuckooMove[8192]", cuckooMove, 0, 8192, T_U16);
+
+  WriteTable(fout, "const uint16_t LOOKUP_INDICES[256][8] ALIGN", LOOKUP_INDICES, 256, 8, T_U16);
+
+  fclose(fout);
+
+  return SaveNetwork(networkPath);
+}
@@ -0,0 +1,40 @@
+// Berserk is a UCI compliant chess engine written in C
+// Copyright (C) 2024 Jay Honnold
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef GENTABLES_H
+#define GENTABLES_H
+
+// The slider table layout depends on PEXT and the network on the
+// permutation for the SIMD width, so prebuilt data is tied to an ARCH
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#define TABLES_SIMD 3
+#elif defined(__AVX2__)
+#define TABLES_SIMD 2
+#elif defined(__SSE4_1__) || defined(__ARM_NEON__)
+#define TABLES_SIMD 1
+#else
+#define TABLES_SIMD 0
+#endif
+
+#ifdef USE_PEXT
+#define TABLES_ARCH (TABLES_SIMD * 2 + 1)
+#else
+#define TABLES_ARCH (TABLES_SIMD * 2)
+#endif
+
+int GenerateTables(char* tablesPath, char* networkPath);
+
+#endif
@@ -41,20 +41,20 @@ void UpdateHistories(SearchStack* ss,
       AddKillerMove(ss, bestMove);
 
       if ((ss - 1)->move)
-        AddCounterMove(thread, bestMove, (ss - 1)->move);
+        AddCounterMove(thread, bestMove, ss - 1);
     }
 
     // Only increase the best move history when it
     // wasn't trivial. This idea was first thought of
     // by Alayan in Ethereal
     if (nQ > 1 || depth > 5) {
-      AddHistoryHeuristic(&HH(stm, bestMove, board->threatened), inc);
-      UpdateCH(ss, bestMove, inc);
+      AddHistoryHeuristic(&HH(stm, bestMove, Threatened(board)), inc);
+      UpdateCH(ss, Moving(board, bestMove), bestMove, inc);
     }
   } else {
-    int piece    = Moving(bestMove);
+    int piece    = Moving(board, bestMove);
     int to       = To(bestMove);
-    int defended = !GetBit(board->threatened, to);
+    int defended = !GetBit(Threatened(board), to);
     int captured = IsEP(bestMove) ? PAWN : PieceType(board->squares[to]);
 
     AddHistoryHeuristic(&TH(piece, to, defended, captured), inc);
@@ -69,8 +69,8 @@ void UpdateHistories(SearchStack* ss,
       if (m == bestMove)
         continue;
 
-      AddHistoryHeuristic(&HH(stm, m, board->threatened), malus);
-      UpdateCH(ss, m, malus);
+      AddHistoryHeuristic(&HH(stm, m, Threatened(board)), malus);
+      UpdateCH(ss, Moving(board, m), m, malus);
     }
   }
 
@@ -80,9 +80,9 @@ void UpdateHistories(SearchStack* ss,
     if (m == bestMove)
       continue;
 
-    int piece    = Moving(m);
+    int piece    = Moving(board, m);
     int to       = To(m);
-    int defended = !GetBit(board->threatened, to);
+    int defended = !GetBit(Threatened(board), to);
     int captured = IsEP(m) ? PAWN : PieceType(board->squares[to]);
 
     AddHistoryHeuristic(&TH(piece, to, defended, captured), -inc);
@@ -98,13 +98,13 @@ void UpdatePawnCorrection(int raw, int real, int depth, Board* board, ThreadData
 void UpdateContCorrection(int raw, int real, int depth, SearchStack* ss) {
   if ((ss - 1)->move && (ss - 2)->move) {
     const int16_t correction = Min(4096, Max(-4096, 4 * (real - raw) * depth));
-    int16_t* contCorrection  = &(*(ss - 2)->cont)[Moving((ss - 1)->move)][To((ss - 1)->move)];
+    int16_t* contCorrection  = &(*(ss - 2)->cont)[(ss - 1)->piece][To((ss - 1)->move)];
     AddHistoryHeuristic(contCorrection, correction);
   }
 
   if ((ss - 1)->move && (ss - 3)->move) {
     const int16_t correction = Min(4096, Max(-4096, 4 * (real - raw) * depth));
-    int16_t* contCorrection  = &(*(ss - 3)->cont)[Moving((ss - 1)->move)][To((ss - 1)->move)];
+    int16_t* contCorrection  = &(*(ss - 3)->cont)[(ss - 1)->piece][To((ss - 1)->move)];
     AddHistoryHeuristic(contCorrection, correction);
   }
 }
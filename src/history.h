@@ -17,6 +17,8 @@
 #ifndef HISTORY_H
 #define HISTORY_H
 
+#include <string.h>
+
 #include "bits.h"
 #include "board.h"
 #include "move.h"
@@ -27,18 +29,20 @@
 #define TH(p, e, d, c)      (thread->caph[p][e][d][c])
 
 INLINE int GetQuietHistory(SearchStack* ss, ThreadData* thread, Move move) {
-  return (int) HH(thread->board.stm, move, thread->board.threatened) + //
-         (int) (*(ss - 1)->ch)[Moving(move)][To(move)] +               //
-         (int) (*(ss - 2)->ch)[Moving(move)][To(move)] +               //
-         (int) (*(ss - 4)->ch)[Moving(move)][To(move)];
+  const int piece = Moving(&thread->board, move);
+
+  return (int) HH(thread->board.stm, move, Threatened(&thread->board)) + //
+         (int) (*(ss - 1)->ch)[piece][To(move)] +                      //
+         (int) (*(ss - 2)->ch)[piece][To(move)] +                      //
+         (int) (*(ss - 4)->ch)[piece][To(move)];
 }
 
 INLINE int GetCaptureHistory(ThreadData* thread, Move move) {
   Board* board = &thread->board;
 
-  return TH(Moving(move),
+  return TH(Moving(board, move),
             To(move),
-            !GetBit(board->threatened, To(move)),
+            !GetBit(Threatened(board), To(move)),
             IsEP(move) ? PAWN : PieceType(board->squares[To(move)]));
 }
 
@@ -53,8 +57,8 @@ INLINE void AddKillerMove(SearchStack* ss, Move move) {
   }
 }
 
-INLINE void AddCounterMove(ThreadData* thread, Move move, Move parent) {
-  thread->counters[Moving(parent)][To(parent)] = move;
+INLINE void AddCounterMove(ThreadData* thread, Move move, SearchStack* parent) {
+  thread->counters[parent->piece][To(parent->move)] = move;
 }
 
 INLINE int16_t HistoryBonus(int depth) {
@@ -65,25 +69,54 @@ INLINE void AddHistoryHeuristic(int16_t* entry, int16_t inc) {
   *entry += inc - *entry * abs(inc) / 16384;
 }
 
-INLINE void UpdateCH(SearchStack* ss, Move move, int16_t bonus) {
+INLINE void UpdateCH(SearchStack* ss, int piece, Move move, int16_t bonus) {
   if ((ss - 1)->move)
-    AddHistoryHeuristic(&(*(ss - 1)->ch)[Moving(move)][To(move)], bonus);
+    AddHistoryHeuristic(&(*(ss - 1)->ch)[piece][To(move)], bonus);
   if ((ss - 2)->move)
-    AddHistoryHeuristic(&(*(ss - 2)->ch)[Moving(move)][To(move)], bonus);
+    AddHistoryHeuristic(&(*(ss - 2)->ch)[piece][To(move)], bonus);
   if ((ss - 4)->move)
-    AddHistoryHeuristic(&(*(ss - 4)->ch)[Moving(move)][To(move)], bonus);
+    AddHistoryHeuristic(&(*(ss - 4)->ch)[piece][To(move)], bonus);
   if ((ss - 6)->move)
-    AddHistoryHeuristic(&(*(ss - 6)->ch)[Moving(move)][To(move)], bonus);
+    AddHistoryHeuristic(&(*(ss - 6)->ch)[piece][To(move)], bonus);
 }
 
 INLINE int GetCorrectionScore(Board* board, ThreadData* thread, SearchStack* ss) {
   const int pawn = thread->pawnCorrection[board->pawnZobrist & PAWN_CORRECTION_MASK];
-  const int cont1 = (*(ss - 3)->cont)[Moving((ss - 1)->move)][To((ss - 1)->move)];
-  const int cont2 = (*(ss - 2)->cont)[Moving((ss - 1)->move)][To((ss - 1)->move)];
+  const int cont1 = (*(ss - 3)->cont)[(ss - 1)->piece][To((ss - 1)->move)];
+  const int cont2 = (*(ss - 2)->cont)[(ss - 1)->piece][To((ss - 1)->move)];
 
   return (31 * pawn + 17 * cont1 + 46 * cont2) / 8192;
 }
 
+// Continuation tables are cleared lazily, an entry left from an older epoch
+// is emptied the first time a search reaches it again
+INLINE void SetContinuation(SearchStack* ss, ThreadData* thread, int piece, int to, int cap) {
+  ContinuationEntry* entry = &thread->continuation[piece][to];
+
+  if (thread->contEpoch[piece][to] != thread->epoch) {
+    memset(entry, 0, sizeof(ContinuationEntry));
+    thread->contEpoch[piece][to] = thread->epoch;
+  }
+
+  ss->ch   = &entry->ch[cap];
+  ss->cont = &entry->cont;
+}
+
+// Called once ss is set up for a move, ahead of making it. The child's
+// correction reads two entries keyed by this move, and its quiet scoring
+// reads the new ch row for every piece of the side it moves
+INLINE void PrefetchContinuation(SearchStack* ss) {
+  const int to = To(ss->move);
+
+  __builtin_prefetch(&(*(ss - 1)->cont)[ss->piece][to]);
+  __builtin_prefetch(&(*(ss - 2)->cont)[ss->piece][to]);
+
+  for (int pc = !(ss->piece & 1); pc < 12; pc += 2) {
+    __builtin_prefetch(&(*ss->ch)[pc][0]);
+    __builtin_prefetch(&(*ss->ch)[pc][32]);
+  }
+}
+
 void UpdateHistories(SearchStack* ss,
                      ThreadData* thread,
                      Move bestMove,
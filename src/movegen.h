@@ -51,19 +51,19 @@ enum {
   GT_LEGAL   = 0b11,
 };
 
-INLINE ScoredMove* AddMove(ScoredMove* moves, int from, int to, int moving, int flags) {
-  *moves++ = (ScoredMove) {.move = BuildMove(from, to, moving, flags), .score = 0};
+INLINE ScoredMove* AddMove(ScoredMove* moves, int from, int to, int flags) {
+  *moves++ = (ScoredMove) {.move = BuildMove(from, to, flags), .score = 0};
   return moves;
 }
 
-INLINE ScoredMove* AddPromotions(ScoredMove* moves, int from, int to, int moving, const int baseFlag, const int type) {
+INLINE ScoredMove* AddPromotions(ScoredMove* moves, int from, int to, const int baseFlag, const int type) {
   if (type & GT_CAPTURE)
-    moves = AddMove(moves, from, to, moving, baseFlag | QUEEN_PROMO_FLAG);
+    moves = AddMove(moves, from, to, baseFlag | QUEEN_PROMO_FLAG);
 
   if (type & GT_QUIET) {
-    moves = AddMove(moves, from, to, moving, baseFlag | ROOK_PROMO_FLAG);
-    moves = AddMove(moves, from, to, moving, baseFlag | BISHOP_PROMO_FLAG);
-    moves = AddMove(moves, from, to, moving, baseFlag | KNIGHT_PROMO_FLAG);
+    moves = AddMove(moves, from, to, baseFlag | ROOK_PROMO_FLAG);
+    moves = AddMove(moves, from, to, baseFlag | BISHOP_PROMO_FLAG);
+    moves = AddMove(moves, from, to, baseFlag | KNIGHT_PROMO_FLAG);
   }
 
   return moves;
@@ -82,12 +82,12 @@ INLINE ScoredMove* AddPawnMoves(ScoredMove* moves, BitBoard opts, Board* board,
 
     while (targets) {
       int to = PopLSB(&targets);
-      moves  = AddMove(moves, to - PawnDir(stm), to, Piece(PAWN, stm), QUIET_FLAG);
+      moves  = AddMove(moves, to - PawnDir(stm), to, QUIET_FLAG);
     }
 
     while (dpTargets) {
       int to = PopLSB(&dpTargets);
-      moves  = AddMove(moves, to - PawnDir(stm) - PawnDir(stm), to, Piece(PAWN, stm), QUIET_FLAG);
+      moves  = AddMove(moves, to - PawnDir(stm) - PawnDir(stm), to, QUIET_FLAG);
     }
   }
 
@@ -99,12 +99,12 @@ INLINE ScoredMove* AddPawnMoves(ScoredMove* moves, BitBoard opts, Board* board,
 
     while (eTargets) {
       int to = PopLSB(&eTargets);
-      moves  = AddMove(moves, to - (PawnDir(stm) + E), to, Piece(PAWN, stm), CAPTURE_FLAG);
+      moves  = AddMove(moves, to - (PawnDir(stm) + E), to, CAPTURE_FLAG);
     }
 
     while (wTargets) {
       int to = PopLSB(&wTargets);
-      moves  = AddMove(moves, to - (PawnDir(stm) + W), to, Piece(PAWN, stm), CAPTURE_FLAG);
+      moves  = AddMove(moves, to - (PawnDir(stm) + W), to, CAPTURE_FLAG);
     }
 
     if (board->epSquare) {
@@ -112,7 +112,7 @@ INLINE ScoredMove* AddPawnMoves(ScoredMove* moves, BitBoard opts, Board* board,
 
       while (movers) {
         int from = PopLSB(&movers);
-        moves    = AddMove(moves, from, board->epSquare, Piece(PAWN, stm), EP_FLAG);
+        moves    = AddMove(moves, from, board->epSquare, EP_FLAG);
       }
     }
   }
@@ -125,17 +125,17 @@ INLINE ScoredMove* AddPawnMoves(ScoredMove* moves, BitBoard opts, Board* board,
 
   while (sTargets) {
     int to = PopLSB(&sTargets);
-    moves  = AddPromotions(moves, to - PawnDir(stm), to, Piece(PAWN, stm), QUIET_FLAG, type);
+    moves  = AddPromotions(moves, to - PawnDir(stm), to, QUIET_FLAG, type);
   }
 
   while (eTargets) {
     int to = PopLSB(&eTargets);
-    moves  = AddPromotions(moves, to - (PawnDir(stm) + E), to, Piece(PAWN, stm), CAPTURE_FLAG, type);
+    moves  = AddPromotions(moves, to - (PawnDir(stm) + E), to, CAPTURE_FLAG, type);
   }
 
   while (wTargets) {
     int to = PopLSB(&wTargets);
-    moves  = AddPromotions(moves, to - (PawnDir(stm) + W), to, Piece(PAWN, stm), CAPTURE_FLAG, type);
+    moves  = AddPromotions(moves, to - (PawnDir(stm) + W), to, CAPTURE_FLAG, type);
   }
 
   return moves;
@@ -160,7 +160,7 @@ INLINE ScoredMove* AddPieceMoves(ScoredMove* moves,
       while (targets) {
         int to = PopLSB(&targets);
 
-        moves = AddMove(moves, from, to, Piece(piece, stm), CAPTURE_FLAG);
+        moves = AddMove(moves, from, to, CAPTURE_FLAG);
       }
     }
 
@@ -170,7 +170,7 @@ INLINE ScoredMove* AddPieceMoves(ScoredMove* moves,
       while (targets) {
         int to = PopLSB(&targets);
 
-        moves = AddMove(moves, from, to, Piece(piece, stm), QUIET_FLAG);
+        moves = AddMove(moves, from, to, QUIET_FLAG);
       }
     }
   }
@@ -198,8 +198,8 @@ INLINE ScoredMove* AddCastles(ScoredMove* moves, Board* board, const int stm) {
     BitBoard between      = kingCrossing | rookCrossing;
 
     if (!((OccBB(BOTH) ^ Bit(from) ^ Bit(rookFrom)) & between))
-      if (!(kingCrossing & board->threatened))
-        moves = AddMove(moves, from, to, Piece(KING, stm), CASTLE_FLAG);
+      if (!(kingCrossing & Threatened(board)))
+        moves = AddMove(moves, from, to, CASTLE_FLAG);
   }
 
   return moves;
@@ -221,7 +221,7 @@ INLINE ScoredMove* AddQuietChecks(ScoredMove* moves, Board* board, const int stm
 
 INLINE ScoredMove* AddPseudoLegalMoves(ScoredMove* moves, Board* board, const int type, const int color) {
   if (BitCount(board->checkers) > 1)
-    return AddPieceMoves(moves, ~board->threatened, board, color, type, KING);
+    return AddPieceMoves(moves, ~Threatened(board), board, color, type, KING);
 
   BitBoard opts =
     !board->checkers ? ALL : BetweenSquares(LSB(PieceBB(KING, color)), LSB(board->checkers)) | board->checkers;
@@ -231,7 +231,7 @@ INLINE ScoredMove* AddPseudoLegalMoves(ScoredMove* moves, Board* board, const in
   moves = AddPieceMoves(moves, opts, board, color, type, BISHOP);
   moves = AddPieceMoves(moves, opts, board, color, type, ROOK);
   moves = AddPieceMoves(moves, opts, board, color, type, QUEEN);
-  moves = AddPieceMoves(moves, ~board->threatened, board, color, type, KING);
+  moves = AddPieceMoves(moves, ~Threatened(board), board, color, type, KING);
   if ((type & GT_QUIET) && !board->checkers)
     moves = AddCastles(moves, board, color);
 
@@ -16,7 +16,11 @@
 
 #include "movepick.h"
 
+#include <limits.h>
 #include <stdio.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #include "board.h"
 #include "eval.h"
@@ -27,14 +31,66 @@
 #include "transposition.h"
 #include "types.h"
 
-INLINE Move Best(ScoredMove* current, ScoredMove* end) {
-  ScoredMove* orig = current;
-  ScoredMove* max  = current;
+// ScoredMove is 8 bytes with the score in the low dword, so a block of
+// 8 moves is two (or one) vector loads with the scores in the even dwords.
+// The max is found over whole blocks and then located with a short scan,
+// which keeps the first of any equal scores just like the plain scan
+#if defined(__AVX2__)
+INLINE int HorizontalMax(__m256i v) {
+  __m128i m = _mm_max_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  m         = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+  m         = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(m);
+}
+
+INLINE ScoredMove* FindBest(ScoredMove* current, ScoredMove* end) {
+  ScoredMove* max = current;
+
+  if (end - current < 8) {
+    while (++current < end)
+      if (current->score > max->score)
+        max = current;
+
+    return max;
+  }
+
+  __m256i best = _mm256_set1_epi32(INT_MIN);
+  for (; current + 8 <= end; current += 8) {
+#if defined(__AVX512F__)
+    __m256i scores = _mm512_cvtepi64_epi32(_mm512_loadu_si512((__m512i*) current));
+#else
+    __m256 a       = _mm256_loadu_ps((float*) current);
+    __m256 b       = _mm256_loadu_ps((float*) (current + 4));
+    __m256i scores = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+#endif
+    best = _mm256_max_epi32(best, scores);
+  }
+
+  int score = HorizontalMax(best);
+  for (; current < end; current++)
+    score = Max(score, current->score);
+
+  while (max->score != score)
+    max++;
+
+  return max;
+}
+#else
+INLINE ScoredMove* FindBest(ScoredMove* current, ScoredMove* end) {
+  ScoredMove* max = current;
 
   while (++current < end)
     if (current->score > max->score)
       max = current;
 
+  return max;
+}
+#endif
+
+INLINE Move Best(ScoredMove* current, ScoredMove* end) {
+  ScoredMove* orig = current;
+  ScoredMove* max  = FindBest(current, end);
+
   ScoredMove temp = *orig;
   *orig           = *max;
   *max            = temp;
@@ -47,21 +103,22 @@ INLINE void ScoreMoves(MovePicker* picker, Board* board, const int type) {
   ThreadData* thread  = picker->thread;
   SearchStack* ss     = picker->ss;
 
-  const BitBoard pawnThreats  = board->threatenedBy[PAWN];
-  const BitBoard minorThreats = pawnThreats | board->threatenedBy[KNIGHT] | board->threatenedBy[BISHOP];
-  const BitBoard rookThreats  = minorThreats | board->threatenedBy[ROOK];
+  const BitBoard threatened   = Threatened(board);
+  const BitBoard pawnThreats  = ThreatenedBy(board, PAWN);
+  const BitBoard minorThreats = pawnThreats | ThreatenedBy(board, KNIGHT) | ThreatenedBy(board, BISHOP);
+  const BitBoard rookThreats  = minorThreats | ThreatenedBy(board, ROOK);
   const BitBoard threats[3]   = {pawnThreats, minorThreats, rookThreats};
 
   while (current < picker->end) {
     const Move move    = current->move;
     const int from     = From(move);
     const int to       = To(move);
-    const int pc       = Moving(move);
+    const int pc       = Moving(board, move);
     const int pt       = PieceType(pc);
     const int captured = IsEP(move) ? PAWN : PieceType(board->squares[to]);
 
     if (type == ST_QUIET || type == ST_EVASION_QT) {
-      current->score = ((int) HH(board->stm, move, board->threatened) * 26 + //
+      current->score = ((int) HH(board->stm, move, threatened) * 26 + //
                         (int) (*(ss - 1)->ch)[pc][to] * 36 +                 //
                         (int) (*(ss - 2)->ch)[pc][to] * 35 +                 //
                         (int) (*(ss - 4)->ch)[pc][to] * 19 +                 //
@@ -87,9 +144,14 @@ INLINE void ScoreMoves(MovePicker* picker, Board* board, const int type) {
 
     current++;
   }
+
+  if (type != ST_QUIET && type != ST_EVASION_QT)
+    SEEMoves(board, picker->current, picker->end);
 }
 
 Move NextMove(MovePicker* picker, Board* board, int skipQuiets) {
+  picker->see = SEE_UNKNOWN;
+
   switch (picker->phase) {
     case HASH_MOVE:
       picker->phase = GEN_NOISY_MOVES;
@@ -108,13 +170,16 @@ Move NextMove(MovePicker* picker, Board* board, int skipQuiets) {
       while (picker->current != picker->end) {
         Move move = Best(picker->current, picker->end);
         int score = picker->current->score;
+        int see   = picker->current->see;
         picker->current++;
 
         if (move == picker->hashMove)
           continue;
 
-        else if (SEE(board, move, -score / 2))
+        else if (see >= -score / 2) {
+          picker->see = see;
           return move;
+        }
 
         *picker->endBad++ = *(picker->current - 1);
       }
@@ -165,10 +230,12 @@ Move NextMove(MovePicker* picker, Board* board, int skipQuiets) {
       // fallthrough
     case PLAY_BAD_NOISY:
       while (picker->current != picker->end) {
-        Move move = (picker->current++)->move;
+        ScoredMove* current = picker->current++;
 
-        if (move != picker->hashMove)
-          return move;
+        if (current->move != picker->hashMove) {
+          picker->see = current->see;
+          return current->move;
+        }
       }
 
       picker->phase = -1;
@@ -185,10 +252,13 @@ Move NextMove(MovePicker* picker, Board* board, int skipQuiets) {
       // fallthrough
     case PC_PLAY_GOOD_NOISY:
       while (picker->current != picker->end) {
-        Move move = Best(picker->current++, picker->end);
+        Move move = Best(picker->current, picker->end);
+        int see   = (picker->current++)->see;
 
-        if (SEE(board, move, picker->seeCutoff))
+        if (see >= picker->seeCutoff) {
+          picker->see = see;
           return move;
+        }
       }
 
       picker->phase = -1;
@@ -204,8 +274,11 @@ Move NextMove(MovePicker* picker, Board* board, int skipQuiets) {
       picker->phase = QS_PLAY_NOISY_MOVES;
       // fallthrough
     case QS_PLAY_NOISY_MOVES:
-      while (picker->current != picker->end)
-        return Best(picker->current++, picker->end);
+      while (picker->current != picker->end) {
+        Move move   = Best(picker->current, picker->end);
+        picker->see = (picker->current++)->see;
+        return move;
+      }
 
       if (!picker->genChecks) {
         picker->phase = -1;
@@ -246,10 +319,13 @@ Move NextMove(MovePicker* picker, Board* board, int skipQuiets) {
       // fallthrough
     case QS_EVASION_PLAY_NOISY:
       while (picker->current != picker->end) {
-        Move move = Best(picker->current++, picker->end);
+        Move move = Best(picker->current, picker->end);
+        int see   = (picker->current++)->see;
 
-        if (move != picker->hashMove)
+        if (move != picker->hashMove) {
+          picker->see = see;
           return move;
+        }
       }
 
       picker->phase = QS_EVASION_GEN_QUIET;
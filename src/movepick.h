@@ -19,6 +19,7 @@
 
 #include "move.h"
 #include "movegen.h"
+#include "see.h"
 #include "types.h"
 #include "util.h"
 
@@ -37,7 +38,7 @@ INLINE void InitNormalMovePicker(MovePicker* picker, Move hashMove, ThreadData*
   picker->killer1  = ss->killers[0];
   picker->killer2  = ss->killers[1];
   if ((ss - 1)->move)
-    picker->counter = thread->counters[Moving((ss - 1)->move)][To((ss - 1)->move)];
+    picker->counter = thread->counters[(ss - 1)->piece][To((ss - 1)->move)];
   else
     picker->counter = NULL_MOVE;
 
@@ -75,4 +76,10 @@ INLINE void InitPerftMovePicker(MovePicker* picker, Board* board) {
 
 Move NextMove(MovePicker* picker, Board* board, int skipQuiets);
 
+// SEE against a threshold for the move just picked, using the exchange
+// value batched in with the noisy list when there is one
+INLINE int PickedSEE(MovePicker* picker, Board* board, Move move, int threshold) {
+  return picker->see != SEE_UNKNOWN ? picker->see >= threshold : SEE(board, move, threshold);
+}
+
 #endif
\ No newline at end of file
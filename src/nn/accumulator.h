@@ -67,7 +67,11 @@
 #define regi_store(a, b) (*(a) = (b))
 #endif
 
+#if defined(SHARED_WEIGHTS)
+extern int16_t* INPUT_WEIGHTS;
+#else
 extern int16_t INPUT_WEIGHTS[N_FEATURES * N_HIDDEN];
+#endif
 extern int16_t INPUT_BIASES[N_HIDDEN];
 
 typedef struct {
@@ -33,12 +33,20 @@
 #define INCBIN_STYLE INCBIN_STYLE_CAMEL
 #include "../incbin.h"
 
+#ifdef PREBUILT_TABLES
+INCBIN(Embed, "prebuilt.nn");
+#else
 INCBIN(Embed, EVALFILE);
+#endif
 
 #define QUANT1_BITS 5
 #define QUANT2_BITS 12
 
+#if defined(SHARED_WEIGHTS)
+int16_t* INPUT_WEIGHTS;
+#else
 int16_t INPUT_WEIGHTS[N_FEATURES * N_HIDDEN] ALIGN;
+#endif
 int16_t INPUT_BIASES[N_HIDDEN] ALIGN;
 
 int8_t L1_WEIGHTS[N_L1 * N_L2] ALIGN;
@@ -50,7 +58,9 @@ int32_t L2_BIASES[N_L3] ALIGN;
 int16_t OUTPUT_WEIGHTS[N_L3 * N_OUTPUT] ALIGN;
 int32_t OUTPUT_BIAS;
 
+#ifndef PREBUILT_TABLES
 uint16_t LOOKUP_INDICES[256][8] ALIGN;
+#endif
 
 #if defined(__AVX512F__) && defined(__AVX512BW__)
 #include <immintrin.h>
@@ -849,16 +859,26 @@ INLINE int WeightIdxScrambled(int idx) {
 INLINE void CopyData(const unsigned char* in) {
   size_t offset = 0;
 
-  // Alloc a chunk of memory for the L1 weights which we
-  // cannot copy into the stack directly
-  int8_t* l1 = malloc(N_L1 * N_L2 * sizeof(int8_t));
-
+#if defined(SHARED_WEIGHTS)
+  // The embedded input weights are used where they sit, so their pages are
+  // shared by every process running this binary. A loaded network gets a copy
+  if (INPUT_WEIGHTS && INPUT_WEIGHTS != (int16_t*) EmbedData)
+    AlignedFree(INPUT_WEIGHTS);
+
+  if (in == EmbedData) {
+    INPUT_WEIGHTS = (int16_t*) EmbedData;
+  } else {
+    INPUT_WEIGHTS = AlignedMalloc(N_FEATURES * N_HIDDEN * sizeof(int16_t), ALIGN_ON);
+    memcpy(INPUT_WEIGHTS, &in[offset], N_FEATURES * N_HIDDEN * sizeof(int16_t));
+  }
+#else
   memcpy(INPUT_WEIGHTS, &in[offset], N_FEATURES * N_HIDDEN * sizeof(int16_t));
+#endif
   offset += N_FEATURES * N_HIDDEN * sizeof(int16_t);
   memcpy(INPUT_BIASES, &in[offset], N_HIDDEN * sizeof(int16_t));
   offset += N_HIDDEN * sizeof(int16_t);
 
-  memcpy(l1, &in[offset], N_L1 * N_L2 * sizeof(int8_t));
+  memcpy(L1_WEIGHTS, &in[offset], N_L1 * N_L2 * sizeof(int8_t));
   offset += N_L1 * N_L2 * sizeof(int8_t);
   memcpy(L1_BIASES, &in[offset], N_L2 * sizeof(int32_t));
   offset += N_L2 * sizeof(int32_t);
@@ -871,17 +891,23 @@ INLINE void CopyData(const unsigned char* in) {
   memcpy(OUTPUT_WEIGHTS, &in[offset], N_L3 * N_OUTPUT * sizeof(int16_t));
   offset += N_L3 * N_OUTPUT * sizeof(int16_t);
   memcpy(&OUTPUT_BIAS, &in[offset], sizeof(int32_t));
+}
 
+// Rearrange the weights for the SIMD width of this build.
+// Prebuilt networks are written after this step, so it's skipped for them
+INLINE void PermuteData() {
 #if defined(__SSE4_1__) || defined(__ARM_NEON__)
+  // Alloc a chunk of memory for the L1 weights which we
+  // cannot copy into the stack directly
+  int8_t* l1 = malloc(N_L1 * N_L2 * sizeof(int8_t));
+  memcpy(l1, L1_WEIGHTS, N_L1 * N_L2 * sizeof(int8_t));
+
   // Shuffle the L1 weights for sparse matmul
   for (int i = 0; i < N_L1 * N_L2; i++)
     L1_WEIGHTS[WeightIdxScrambled(i)] = l1[i];
-#else
-  for (int i = 0; i < N_L1 * N_L2; i++)
-    L1_WEIGHTS[i] = l1[i];
-#endif
 
   free(l1);
+#endif
 
 #if defined(__AVX512F__) && defined(__AVX512BW__)
   const size_t WIDTH         = sizeof(__m512i) / sizeof(int16_t);
@@ -948,6 +974,7 @@ INLINE void CopyData(const unsigned char* in) {
 #endif
 }
 
+#ifndef PREBUILT_TABLES
 INLINE void InitLookupIndices() {
   for (size_t i = 0; i < 256; i++) {
     uint64_t j = i;
@@ -956,11 +983,24 @@ INLINE void InitLookupIndices() {
       LOOKUP_INDICES[i][k++] = PopLSB(&j);
   }
 }
+#endif
+
+static void ResetThreadRefreshTable(ThreadData* thread) {
+  ResetRefreshTable(thread->refreshTable);
+}
 
 void LoadDefaultNN() {
+#ifndef PREBUILT_TABLES
   InitLookupIndices();
 
   CopyData(EmbedData);
+  PermuteData();
+#else
+  CopyData(EmbedData);
+#endif
+
+  // No threads yet at startup, this matters when switching back from an EvalFile
+  ThreadsRun(ResetThreadRefreshTable);
 }
 
 int LoadNetwork(char* path) {
@@ -977,12 +1017,34 @@ int LoadNetwork(char* path) {
   }
 
   CopyData(data);
+  PermuteData();
 
-  for (int i = 0; i < Threads.count; i++)
-    ResetRefreshTable(Threads.threads[i]->refreshTable);
+  ThreadsRun(ResetThreadRefreshTable);
 
   fclose(fin);
   free(data);
 
   return 1;
 }
+
+// Write out the loaded network as it sits in memory, after PermuteData
+int SaveNetwork(char* path) {
+  FILE* fout = fopen(path, "wb");
+  if (fout == NULL) {
+    printf("info string Unable to write file at %s\n", path);
+    return 0;
+  }
+
+  fwrite(INPUT_WEIGHTS, sizeof(int16_t), N_FEATURES * N_HIDDEN, fout);
+  fwrite(INPUT_BIASES, sizeof(int16_t), N_HIDDEN, fout);
+  fwrite(L1_WEIGHTS, sizeof(int8_t), N_L1 * N_L2, fout);
+  fwrite(L1_BIASES, sizeof(int32_t), N_L2, fout);
+  fwrite(L2_WEIGHTS, sizeof(int16_t), N_L2 * N_L3, fout);
+  fwrite(L2_BIASES, sizeof(int32_t), N_L3, fout);
+  fwrite(OUTPUT_WEIGHTS, sizeof(int16_t), N_L3 * N_OUTPUT, fout);
+  fwrite(&OUTPUT_BIAS, sizeof(int32_t), 1, fout);
+
+  fclose(fout);
+
+  return 1;
+}
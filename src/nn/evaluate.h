@@ -21,10 +21,13 @@
 
 #define SPARSE_CHUNK_SIZE 4
 
+extern TABLE uint16_t LOOKUP_INDICES[256][8];
+
 int Predict(Board* board);
 int Propagate(Accumulator* accumulator, const int stm);
 
 void LoadDefaultNN();
 int LoadNetwork(char* path);
+int SaveNetwork(char* path);
 
 #endif
@@ -14,37 +14,87 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include "perft.h"
+
 #include <inttypes.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "board.h"
 #include "move.h"
 #include "movegen.h"
-#include "movepick.h"
+#include "thread.h"
 #include "types.h"
 #include "util.h"
 
-uint64_t Perft(int depth, Board* board) {
+// Perft hash shared by all threads, 32MB. The key is stored xor'd with
+// the data so a torn write from another thread can't produce a false hit
+#define PERFT_HASH_SIZE (1 << 21)
+#define PERFT_HASH_MASK (PERFT_HASH_SIZE - 1)
+
+typedef struct {
+  uint64_t key;
+  uint64_t data; // nodes << 8 | depth
+} PerftEntry;
+
+static PerftEntry* perftHash;
+
+// Root moves are handed out one at a time to whichever thread is free
+static Board* perftRoot;
+static int perftDepth;
+static int perftCount;
+static atomic_int perftNext;
+static ScoredMove perftMoves[MAX_MOVES];
+static uint64_t perftNodes[MAX_MOVES];
+
+// Generate legal moves straight into a list, no move picker, and bulk
+// count at depth 1. Each ply gets its own board one slot further into
+// the stack, so undoing a move is just going back to the parent's
+static uint64_t Perft(int depth, Board* board) {
   if (depth == 0)
     return 1;
 
-  Move move;
-  MovePicker mp;
-  InitPerftMovePicker(&mp, board);
+  ScoredMove moves[MAX_MOVES];
+  ScoredMove* end = AddPerftMoves(moves, board);
 
   if (depth == 1)
-    return mp.end - mp.moves;
+    return end - moves;
+
+  uint64_t key      = board->zobrist ^ (depth * 0x9E3779B97F4A7C15ULL);
+  PerftEntry* entry = &perftHash[key & PERFT_HASH_MASK];
+  uint64_t data     = entry->data;
+
+  if ((entry->key ^ data) == key && (int) (data & 0xff) == depth)
+    return data >> 8;
 
   uint64_t nodes = 0;
-  while ((move = NextMove(&mp, board, 0))) {
-    MakeMoveUpdate(move, board, 0);
-    nodes += Perft(depth - 1, board);
-    UndoMove(move, board);
+  for (ScoredMove* curr = moves; curr != end; curr++) {
+    MakeMoveCopy(curr->move, board, board + 1);
+    nodes += Perft(depth - 1, board + 1);
   }
 
+  data        = nodes << 8 | depth;
+  entry->key  = key ^ data;
+  entry->data = data;
+
   return nodes;
 }
 
+static void PerftThread(ThreadData* thread) {
+  (void) thread;
+
+  Board* stack = malloc(Max(1, perftDepth) * sizeof(Board));
+
+  int i;
+  while ((i = atomic_fetch_add(&perftNext, 1)) < perftCount) {
+    MakeMoveCopy(perftMoves[i].move, perftRoot, stack);
+    perftNodes[i] = Perft(perftDepth - 1, stack);
+  }
+
+  free(stack);
+}
+
 void PerftTest(int depth, Board* board) {
   uint64_t total = 0;
 
@@ -52,22 +102,24 @@ void PerftTest(int depth, Board* board) {
 
   long startTime = GetTimeMS();
 
-  Move move;
-  MovePicker mp;
-  InitPerftMovePicker(&mp, board);
+  perftHash  = calloc(PERFT_HASH_SIZE, sizeof(PerftEntry));
+  perftRoot  = board;
+  perftDepth = Max(1, depth);
+  perftCount = AddPerftMoves(perftMoves, board) - perftMoves;
+  atomic_store(&perftNext, 0);
 
-  while ((move = NextMove(&mp, board, 0))) {
-    MakeMoveUpdate(move, board, 0);
-    uint64_t nodes = Perft(depth - 1, board);
-    UndoMove(move, board);
+  ThreadsRun(PerftThread);
 
-    printf("%5s: %" PRIu64 "\n", MoveToStr(move, board), nodes);
-    total += nodes;
-  }
+  free(perftHash);
 
   long endTime = GetTimeMS();
 
+  for (int i = 0; i < perftCount; i++) {
+    printf("%5s: %" PRIu64 "\n", MoveToStr(perftMoves[i].move, board), perftNodes[i]);
+    total += perftNodes[i];
+  }
+
   printf("\nNodes: %" PRIu64 "\n", total);
   printf("Time: %ldms\n", (endTime - startTime));
   printf("NPS: %" PRIu64 "\n\n", total / Max(1, (endTime - startTime)) * 1000);
-}
\ No newline at end of file
+}
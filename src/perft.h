@@ -19,7 +19,6 @@
 
 #include "types.h"
 
-int Perft(int depth, Board* board);
 void PerftTest(int depth, Board* board);
 
 #endif
\ No newline at end of file
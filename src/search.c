@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "board.h"
+#include "cluster.h"
 #include "eval.h"
 #include "history.h"
 #include "move.h"
@@ -41,6 +42,21 @@
 #include "util.h"
 #include "zobrist.h"
 
+// Node types, each search is specialized on these at compile time
+// in the same way that GT_* specializes move generation
+enum {
+  NT_NON_PV,
+  NT_PV,
+  NT_ROOT,
+};
+
+static int NegamaxRoot(int alpha, int beta, int depth, int cutnode, ThreadData* thread, SearchStack* ss);
+static int NegamaxPV(int alpha, int beta, int depth, int cutnode, ThreadData* thread, SearchStack* ss);
+static int NegamaxNonPV(int alpha, int beta, int depth, int cutnode, ThreadData* thread, SearchStack* ss);
+static int QuiescePV(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss);
+static int QuiesceNonPV(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss);
+
+#ifndef PREBUILT_TABLES
 // arrays to store these pruning cutoffs at specific depths
 int LMR[MAX_SEARCH_PLY][64];
 int LMP[2][MAX_SEARCH_PLY];
@@ -64,18 +80,20 @@ void InitPruningAndReductionTables() {
     STATIC_PRUNE[1][depth] = -108.3466 * depth;         // capture cutoff
   }
 }
+#endif
 
+// Time is handled by the timer thread, only node limits are checked
+// inline so that they remain deterministic
 INLINE int CheckLimits(ThreadData* thread) {
-  if (--thread->calls > 0)
+  if (!Limits.nodes || --thread->calls > 0)
     return 0;
   thread->calls = Limits.hitrate;
 
-  if (Threads.ponder)
+  if (Threads.ponder || NodesSearched() < Limits.nodes)
     return 0;
 
-  long elapsed = GetTimeMS() - Limits.start;
-  return (Limits.timeset && elapsed >= Limits.max) || //
-         (Limits.nodes && NodesSearched() >= Limits.nodes);
+  Threads.stop = 1;
+  return 1;
 }
 
 INLINE int AdjustEvalOnFMR(Board* board, int eval) {
@@ -102,32 +120,23 @@ void StartSearch(Board* board, uint8_t ponder) {
   ThreadWake(Threads.threads[0], THREAD_SEARCH);
 }
 
-void MainSearch() {
-  ThreadData* mainThread = Threads.threads[0];
-  Board* board           = &mainThread->board;
-
-  char startFen[128];
-  BoardToFen(startFen, board);
-
-  TTUpdate();
-
-  for (int i = 1; i < Threads.count; i++)
-    ThreadWake(Threads.threads[i], THREAD_SEARCH);
-  Search(mainThread);
-
-  pthread_mutex_lock(&Threads.lock);
-  if (!Threads.stop && (Threads.ponder || Limits.infinite)) {
-    Threads.sleeping = 1;
-    pthread_mutex_unlock(&Threads.lock);
-    ThreadWait(mainThread, &Threads.stop);
-  } else {
-    pthread_mutex_unlock(&Threads.lock);
-  }
+// Tell a running search to stop, waking the main thread if it is holding
+// an infinite or ponder result. Returns without waiting for the bestmove
+void StopSearch() {
+  if (!Threads.searching)
+    return;
 
   Threads.stop = 1;
+  pthread_mutex_lock(&Threads.lock);
+  if (Threads.sleeping)
+    ThreadWake(Threads.threads[0], THREAD_RESUME);
+  Threads.sleeping = 0;
+  pthread_mutex_unlock(&Threads.lock);
+}
 
-  for (int i = 1; i < Threads.count; i++)
-    ThreadWaitUntilSleep(Threads.threads[i]);
+// Lazy SMP voting, the chosen thread is swapped into the main thread slot
+static void ChooseBestThread(Board* board) {
+  ThreadData* mainThread = Threads.threads[0];
 
   int voteMap[64 * 64];
   int worstScore = UNKNOWN;
@@ -181,7 +190,199 @@ void MainSearch() {
     bestThread->idx    = 0;
     Threads.threads[0] = bestThread;
   }
+}
+
+// Pondering on the expected reply alone wastes the whole ponder time when the
+// opponent plays something else. With PonderReplies > 1 the position before
+// the reply is searched instead, with a multipv line for each of the most
+// likely replies. Whichever of them is played finds its subtree in the TT,
+// the root move ordering included.
+static SearchParams ponderLimits;      // limits for the real search, used on ponderhit
+static uint64_t ponderKey;             // the position the GUI asked us to ponder on
+static Move ponderFallback;            // a legal move in ponderKey, for a stop before any line finished
+static uint64_t predicted[MAX_MOVES];  // the expected reply, then the best of the others
+static int numPredicted;
+static int ponders, primaryHits, anyHits;
+
+void StartPonderReplies(Board* board, Board* parent, int replies) {
+  SimpleMoveList moves;
+  RootMoves(&moves, board);
+
+  ponderLimits   = Limits;
+  ponderKey      = board->zobrist;
+  ponderFallback = moves.count ? moves.moves[0] : NULL_MOVE;
+  numPredicted   = 0;
+
+  RootMoves(&moves, parent);
+
+  // Plain MultiPV rather than split: split lines are ranked by the depth
+  // they reached first, and a reply once pushed out of the top K is never
+  // searched again. Here every thread searches all K lines, Lazy SMP style
+  Limits.multiPV       = Min(replies, moves.count);
+  Limits.splitMultiPV  = 0;
+  Limits.searchMoves   = 0;
+  Limits.timeset       = 0;
+  Limits.max           = INT_MAX;
+  Limits.depth         = MAX_SEARCH_PLY - 1;
+  Limits.mate          = 0;
+  Limits.nodes         = 0;
+  Limits.hitrate       = 1000;
+  Limits.infinite      = 1;
+  Limits.ponderReplies = 1;
+  Limits.ponderHit     = 0;
+
+  StartSearch(parent, 1);
+}
+
+// Called from MainSearch once the parent search is stopped. On a ponderhit
+// the real search follows, otherwise the GUI still waits for a bestmove in
+// the position it sent with "go ponder"
+static void FinishPonderReplies(ThreadData* thread, Board* board) {
+  // Replies are ranked by their scores at the deepest iteration every line
+  // completed. Once the next iteration has started those are previousScore
+  int depth = thread->rootMoves[0].depth;
+  for (int i = 1; i < Limits.multiPV; i++)
+    depth = Min(depth, thread->rootMoves[i].depth);
+
+  Move ranked[MAX_MOVES];
+  int scores[MAX_MOVES], numRanked = 0;
+  for (int i = 0; i < thread->numRootMoves; i++) {
+    RootMove* line = &thread->rootMoves[i];
+    if (line->depth < depth)
+      continue;
+
+    int score = thread->depth > depth ? line->previousScore : line->score;
+
+    int j = numRanked++;
+    for (; j > 0 && score > scores[j - 1]; j--)
+      ranked[j] = ranked[j - 1], scores[j] = scores[j - 1];
+    ranked[j] = line->move, scores[j] = score;
+  }
+
+  // The expected reply is always predicted, so a primary hit is one of K too
+  predicted[numPredicted++] = ponderKey;
+  for (int r = 0; r < numRanked && numPredicted < Limits.multiPV; r++) {
+    Move reply = ranked[r];
+
+    MakeMove(reply, board);
+    if (board->zobrist != ponderKey)
+      predicted[numPredicted++] = board->zobrist;
+    UndoMove(reply, board);
+  }
+
+  Move bestMove = ponderFallback;
 
+  for (int i = 0; i < thread->numRootMoves; i++) {
+    RootMove* line = &thread->rootMoves[i];
+    MakeMove(line->move, board);
+
+    if (board->zobrist == ponderKey) {
+      if (i < Limits.multiPV && line->pv.count > 1)
+        bestMove = line->pv.moves[1];
+      else {
+        // The expected reply didn't make the cut, the TT still knows something
+        Move hashMove = NULL_MOVE;
+        int ttHit = 0, ttScore, ttEval, ttDepth, ttBound, ttPv = 0;
+        TTProbe(board->zobrist, 0, &ttHit, &hashMove, &ttScore, &ttEval, &ttDepth, &ttBound, &ttPv);
+
+        if (ttHit && IsPseudoLegal(hashMove, board) && IsLegal(hashMove, board))
+          bestMove = hashMove;
+      }
+    }
+
+    UndoMove(line->move, board);
+  }
+
+  Limits.ponderReplies = 0;
+  if (Limits.ponderHit)
+    return;
+
+  printf("bestmove %s\n", MoveToStr(bestMove, board));
+}
+
+static void ScorePrediction(uint64_t key) {
+  ponders++;
+  primaryHits += key == ponderKey;
+
+  for (int i = 0; i < numPredicted; i++)
+    if (predicted[i] == key) {
+      anyHits++;
+      break;
+    }
+
+  printf("info string ponder hits %d/%d, within %d replies %d/%d\n",
+         primaryHits,
+         ponders,
+         numPredicted,
+         anyHits,
+         ponders);
+  numPredicted = 0;
+}
+
+// "ponderhit" with PonderReplies > 1, the parent search is stopped and the
+// real one started in board with the limits from "go ponder"
+void PonderHit(Board* board) {
+  Limits.ponderHit = 1;
+
+  StopSearch();
+  ThreadWaitUntilSleep(Threads.threads[0]);
+  ScorePrediction(board->zobrist);
+
+  Limits       = ponderLimits;
+  Limits.start = GetTimeMS();
+  StartSearch(board, 0);
+}
+
+// A regular "go" after pondering on replies, the opponent didn't play the
+// expected move. Only counts how often one of the other lines was played
+void PonderResult(Board* board) {
+  if (Threads.searching)
+    ThreadWaitUntilSleep(Threads.threads[0]);
+
+  if (numPredicted)
+    ScorePrediction(board->zobrist);
+}
+
+void MainSearch() {
+  ThreadData* mainThread = Threads.threads[0];
+  Board* board           = &mainThread->board;
+
+  TTUpdate();
+  TimerStart();
+  ClusterStartSearch(board);
+
+  ThreadsWake(1, THREAD_SEARCH);
+  Search(mainThread);
+
+  pthread_mutex_lock(&Threads.lock);
+  if (!Threads.stop && (Threads.ponder || Limits.infinite)) {
+    Threads.sleeping = 1;
+    pthread_mutex_unlock(&Threads.lock);
+    ThreadWait(&Threads.stop);
+  } else {
+    pthread_mutex_unlock(&Threads.lock);
+  }
+
+  Threads.stop = 1;
+  TimerStop();
+  ClusterStopSearch();
+
+  for (int i = 1; i < Threads.count; i++)
+    ThreadWaitUntilSleep(Threads.threads[i]);
+
+  if (Limits.ponderReplies) {
+    FinishPonderReplies(mainThread, board);
+    return;
+  }
+
+  if (Limits.splitMultiPV) {
+    // No voting, the merged lines already hold the deepest result for every move
+    SyncRootMoves(mainThread);
+    PrintUCI(mainThread, -CHECKMATE, CHECKMATE, board);
+  } else
+    ChooseBestThread(board);
+
+  ThreadData* bestThread    = Threads.threads[0];
   bestThread->previousScore = bestThread->rootMoves[0].score;
 
   Move bestMove   = bestThread->rootMoves[0].move;
@@ -190,9 +391,6 @@ void MainSearch() {
     ponderMove = bestThread->rootMoves[0].pv.moves[1];
   else {
     // Pull ponder move from the TT if PV doesn't have one.
-    // We reload the startfen because jmp aborts don't guarantee a rolled back board
-    ParseFen(startFen, board);
-
     MakeMove(bestMove, board);
     int ttHit = 0, ttScore, ttEval, ttDepth, ttBound, ttPv = 0;
     TTProbe(board->zobrist, 0, &ttHit, &ponderMove, &ttScore, &ttEval, &ttDepth, &ttBound, &ttPv);
@@ -204,23 +402,30 @@ void MainSearch() {
     UndoMove(bestMove, board);
   }
 
+  ClusterFinishSearch(bestThread, &bestMove, &ponderMove);
+
   printf("bestmove %s", MoveToStr(bestMove, board));
   if (ponderMove)
     printf(" ponder %s", MoveToStr(ponderMove, board));
   printf("\n");
 }
 
+INLINE int NextLine(ThreadData* thread, int prev) {
+  if (Limits.splitMultiPV)
+    return NextSplitLine(thread);
+
+  return prev + 1;
+}
+
 void Search(ThreadData* thread) {
   Board* board   = &thread->board;
   int mainThread = !thread->idx;
 
-  thread->depth       = 0;
-  board->accumulators = thread->accumulators; // exit jumps can cause this pointer to not be reset
+  thread->depth = 0;
   ResetAccumulator(board->accumulators, board, WHITE);
   ResetAccumulator(board->accumulators, board, BLACK);
   SetContempt(thread->contempt, board->stm);
 
-  PV nullPv;
   int scores[MAX_SEARCH_PLY];
   int searchStability   = 0;
   Move previousBestMove = NULL_MOVE;
@@ -232,27 +437,19 @@ void Search(ThreadData* thread) {
   for (size_t i = 0; i < MAX_SEARCH_PLY; i++)
     (ss + i)->ply = i, (ss + i)->reduction = 0;
   for (size_t i = 1; i <= searchOffset; i++) {
-    (ss - i)->ch        = &thread->ch[0][WHITE_PAWN][A1];
-    (ss - i)->cont      = &thread->contCorrection[WHITE_PAWN][A1];
+    SetContinuation(ss - i, thread, WHITE_PAWN, A1, 0);
     (ss - i)->reduction = 0;
   }
 
   while (++thread->depth < MAX_SEARCH_PLY) {
-#if defined(_WIN32) || defined(_WIN64)
-    if (_setjmp(thread->exit, NULL)) {
-#else
-    if (setjmp(thread->exit)) {
-#endif
-      break;
-    }
-
     if (Limits.depth && mainThread && thread->depth > Limits.depth)
       break;
 
     for (int i = 0; i < thread->numRootMoves; i++)
       thread->rootMoves[i].previousScore = thread->rootMoves[i].score;
 
-    for (thread->multiPV = 0; thread->multiPV < Limits.multiPV; thread->multiPV++) {
+    for (thread->multiPV = NextLine(thread, -1); thread->multiPV < Limits.multiPV;
+         thread->multiPV = NextLine(thread, thread->multiPV)) {
       int alpha       = -CHECKMATE;
       int beta        = CHECKMATE;
       int delta       = CHECKMATE;
@@ -277,7 +474,10 @@ void Search(ThreadData* thread) {
           beta = CHECKMATE;
 
         // search!
-        score = Negamax(alpha, beta, Max(1, searchDepth), 0, thread, &nullPv, ss);
+        score = Negamax(alpha, beta, Max(1, searchDepth), 0, thread, ss);
+
+        if (LoadRlx(Threads.stop))
+          break;
 
         SortRootMoves(thread, thread->multiPV);
 
@@ -305,13 +505,29 @@ void Search(ThreadData* thread) {
         delta += 16 * delta / 64;
       }
 
-      SortRootMoves(thread, 0);
+      if (LoadRlx(Threads.stop))
+        break;
+
+      thread->rootMoves[thread->multiPV].depth = thread->depth;
+
+      if (Limits.splitMultiPV)
+        PublishRootMove(thread);
+      else
+        SortRootMoves(thread, 0);
 
       // Print if final multipv or time elapsed
-      if (mainThread && (thread->multiPV + 1 == Limits.multiPV || GetTimeMS() - Limits.start >= 2500))
+      if (mainThread && !Limits.splitMultiPV &&
+          (thread->multiPV + 1 == Limits.multiPV || GetTimeMS() - Limits.start >= 2500))
         PrintUCI(thread, -CHECKMATE, CHECKMATE, board);
     }
 
+    if (LoadRlx(Threads.stop))
+      break;
+
+    // Every split line has now been completed at this depth, by some thread
+    if (mainThread && Limits.splitMultiPV)
+      PrintUCI(thread, -CHECKMATE, CHECKMATE, board);
+
     if (!mainThread)
       continue;
 
@@ -362,18 +578,25 @@ void Search(ThreadData* thread) {
   }
 }
 
-int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV* pv, SearchStack* ss) {
+INLINE int NegamaxNode(int alpha,
+                       int beta,
+                       int depth,
+                       int cutnode,
+                       ThreadData* thread,
+                       SearchStack* ss,
+                       const int nodeType) {
   Board* board = &thread->board;
 
-  PV childPv;
-  pv->count = 0;
+  PV* pv      = &thread->pvs[ss->ply];
+  PV* childPv = pv + 1;
+  pv->count   = 0;
 
-  int isPV      = beta - alpha != 1; // pv node when doing a full window
-  int isRoot    = !ss->ply;          //
-  int score     = -CHECKMATE;        // initially assume the worst case
-  int bestScore = -CHECKMATE;        //
-  int maxScore  = CHECKMATE;         // best possible
-  int origAlpha = alpha;             // remember first alpha for tt storage
+  int isPV      = nodeType != NT_NON_PV; // pv node when doing a full window
+  int isRoot    = nodeType == NT_ROOT;   //
+  int score     = -CHECKMATE;             // initially assume the worst case
+  int bestScore = -CHECKMATE;             //
+  int maxScore  = CHECKMATE;              // best possible
+  int origAlpha = alpha;                  // remember first alpha for tt storage
   int inCheck   = !!board->checkers;
   int improving = 0;
   int eval      = ss->staticEval;
@@ -393,9 +616,9 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
   if (depth <= 0)
     return Quiesce(alpha, beta, 0, thread, ss);
 
+  // abort, every caller discards the result once stop is set
   if (LoadRlx(Threads.stop) || (!thread->idx && CheckLimits(thread)))
-    // hot exit
-    longjmp(thread->exit, 1);
+    return 0;
 
   if (isPV && thread->seldepth < ss->ply + 1)
     thread->seldepth = ss->ply + 1;
@@ -440,7 +663,7 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
     unsigned tbResult = TBProbe(board);
 
     if (tbResult != TB_RESULT_FAILED) {
-      IncRlx(thread->tbhits);
+      IncOwnRlx(thread->tbhits);
 
       score     = tbResult == TB_WIN ? TB_WIN_SCORE - ss->ply : tbResult == TB_LOSS ? -TB_WIN_SCORE + ss->ply : 0;
       int bound = tbResult == TB_WIN ? BOUND_LOWER : tbResult == TB_LOSS ? BOUND_UPPER : BOUND_EXACT;
@@ -524,7 +747,7 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
 
     // Razoring
     if (depth <= 5 && eval + 146 * depth <= alpha) {
-      score = Quiesce(alpha, beta, 0, thread, ss);
+      score = QuiesceNonPV(alpha, beta, 0, thread, ss);
       if (score <= alpha)
         return score;
     }
@@ -538,16 +761,19 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
       int R = 4 + 367 * depth / 1024 + Min(9 * (eval - beta) / 1024, 4);
 
       TTPrefetch(KeyAfter(board, NULL_MOVE));
-      ss->move = NULL_MOVE;
-      ss->ch   = &thread->ch[0][WHITE_PAWN][A1];
-      ss->cont = &thread->contCorrection[WHITE_PAWN][A1];
-      IncRlx(thread->nodes);
+      ss->move  = NULL_MOVE;
+      ss->piece = WHITE_PAWN;
+      SetContinuation(ss, thread, WHITE_PAWN, A1, 0);
+      IncOwnRlx(thread->nodes);
       MakeNullMove(board);
 
-      score = -Negamax(-beta, -beta + 1, depth - R, !cutnode, thread, &childPv, ss + 1);
+      score = -NegamaxNonPV(-beta, -beta + 1, depth - R, !cutnode, thread, ss + 1);
 
       UndoNullMove(board);
 
+      if (LoadRlx(Threads.stop))
+        return 0;
+
       if (score >= beta) {
         if (score >= TB_WIN_BOUND)
           score = beta;
@@ -558,10 +784,13 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
         thread->nmpMinPly = ss->ply + 3 * (depth - R) / 4;
         thread->npmColor  = board->stm;
 
-        Score verify = Negamax(beta - 1, beta, depth - R, 0, thread, pv, ss);
+        Score verify = NegamaxNonPV(beta - 1, beta, depth - R, 0, thread, ss);
 
         thread->nmpMinPly = 0;
 
+        if (LoadRlx(Threads.stop))
+          return 0;
+
         if (verify >= beta)
           return score;
       }
@@ -578,21 +807,25 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
           continue;
 
         TTPrefetch(KeyAfter(board, move));
-        ss->move = move;
-        ss->ch   = &thread->ch[IsCap(move)][Moving(move)][To(move)];
-        ss->cont = &thread->contCorrection[Moving(move)][To(move)];
-        IncRlx(thread->nodes);
+        ss->move  = move;
+        ss->piece = Moving(board, move);
+        SetContinuation(ss, thread, ss->piece, To(move), IsCap(move));
+        PrefetchContinuation(ss);
+        IncOwnRlx(thread->nodes);
         MakeMove(move, board);
 
         // qsearch to quickly check
-        score = -Quiesce(-probBeta, -probBeta + 1, 0, thread, ss + 1);
+        score = -QuiesceNonPV(-probBeta, -probBeta + 1, 0, thread, ss + 1);
 
         // if it's still above our cutoff, revalidate
         if (score >= probBeta)
-          score = -Negamax(-probBeta, -probBeta + 1, depth - 4, !cutnode, thread, pv, ss + 1);
+          score = -NegamaxNonPV(-probBeta, -probBeta + 1, depth - 4, !cutnode, thread, ss + 1);
 
         UndoMove(move, board);
 
+        if (LoadRlx(Threads.stop))
+          return 0;
+
         if (score >= probBeta)
           return score;
       }
@@ -640,10 +873,10 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
         if (!inCheck && lmrDepth < 10 && eval + 66 + 44 * lmrDepth <= alpha)
           skipQuiets = 1;
 
-        if (!SEE(board, move, STATIC_PRUNE[0][lmrDepth]))
+        if (!PickedSEE(&mp, board, move, STATIC_PRUNE[0][lmrDepth]))
           continue;
       } else {
-        if (!SEE(board, move, STATIC_PRUNE[1][depth]))
+        if (!PickedSEE(&mp, board, move, STATIC_PRUNE[1][depth]))
           continue;
       }
     }
@@ -675,9 +908,12 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
         int sDepth = (depth - 1) / 2;
 
         ss->skip = move;
-        score    = Negamax(sBeta - 1, sBeta, sDepth, cutnode, thread, pv, ss);
+        score    = NegamaxNonPV(sBeta - 1, sBeta, sDepth, cutnode, thread, ss);
         ss->skip = NULL_MOVE;
 
+        if (LoadRlx(Threads.stop))
+          return 0;
+
         // no score failed above sBeta, so this is singular
         if (score < sBeta) {
           if (!isPV && score < sBeta - 43 && ss->de <= 7 && !IsCap(move)) {
@@ -701,10 +937,11 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
     }
 
     TTPrefetch(KeyAfter(board, move));
-    ss->move = move;
-    ss->ch   = &thread->ch[IsCap(move)][Moving(move)][To(move)];
-    ss->cont = &thread->contCorrection[Moving(move)][To(move)];
-    IncRlx(thread->nodes);
+    ss->move  = move;
+    ss->piece = Moving(board, move);
+    SetContinuation(ss, thread, ss->piece, To(move), IsCap(move));
+    PrefetchContinuation(ss);
+    IncOwnRlx(thread->nodes);
     MakeMove(move, board);
 
     // apply extensions
@@ -743,7 +980,7 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
       ss->reduction = R;
 
       int lmrDepth = newDepth - R;
-      score        = -Negamax(-alpha - 1, -alpha, lmrDepth, 1, thread, &childPv, ss + 1);
+      score        = -NegamaxNonPV(-alpha - 1, -alpha, lmrDepth, 1, thread, ss + 1);
 
       ss->reduction = 0;
 
@@ -754,20 +991,23 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
         newDepth -= (score < bestScore + newDepth);
 
         if (newDepth - 1 > lmrDepth)
-          score = -Negamax(-alpha - 1, -alpha, newDepth - 1, !cutnode, thread, &childPv, ss + 1);
+          score = -NegamaxNonPV(-alpha - 1, -alpha, newDepth - 1, !cutnode, thread, ss + 1);
 
         int bonus = score <= alpha ? -HistoryBonus(newDepth - 1) : score >= beta ? HistoryBonus(newDepth - 1) : 0;
-        UpdateCH(ss, move, bonus);
+        UpdateCH(ss, ss->piece, move, bonus);
       }
     } else if (!isPV || playedMoves > 1) {
-      score = -Negamax(-alpha - 1, -alpha, newDepth - 1, !cutnode, thread, &childPv, ss + 1);
+      score = -NegamaxNonPV(-alpha - 1, -alpha, newDepth - 1, !cutnode, thread, ss + 1);
     }
 
     if (isPV && (playedMoves == 1 || (score > alpha && (isRoot || score < beta))))
-      score = -Negamax(-beta, -alpha, newDepth - 1, 0, thread, &childPv, ss + 1);
+      score = -Negamax(-beta, -alpha, newDepth - 1, 0, thread, ss + 1);
 
     UndoMove(move, board);
 
+    if (LoadRlx(Threads.stop))
+      return 0;
+
     if (isRoot) {
       RootMove* rm = thread->rootMoves;
       for (int i = 1; i < thread->numRootMoves; i++)
@@ -783,9 +1023,9 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
         rm->score    = score;
         rm->seldepth = thread->seldepth;
 
-        rm->pv.count    = childPv.count + 1;
+        rm->pv.count    = childPv->count + 1;
         rm->pv.moves[0] = move;
-        memcpy(rm->pv.moves + 1, childPv.moves, childPv.count * sizeof(Move));
+        memcpy(rm->pv.moves + 1, childPv->moves, childPv->count * sizeof(Move));
       } else {
         rm->score = -CHECKMATE;
       }
@@ -795,9 +1035,9 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
       bestScore = score;
 
       if (isPV && !isRoot && score > alpha) {
-        pv->count    = childPv.count + 1;
+        pv->count    = childPv->count + 1;
         pv->moves[0] = move;
-        memcpy(pv->moves + 1, childPv.moves, childPv.count * sizeof(Move));
+        memcpy(pv->moves + 1, childPv->moves, childPv->count * sizeof(Move));
       }
 
       if (score > alpha) {
@@ -825,9 +1065,13 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
 
   // prevent saving when in singular search
   int bound = bestScore >= beta ? BOUND_LOWER : bestScore <= origAlpha ? BOUND_UPPER : BOUND_EXACT;
-  if (!ss->skip && !(isRoot && thread->multiPV > 0))
+  if (!ss->skip && !(isRoot && thread->multiPV > 0)) {
     TTPut(tt, board->zobrist, depth, bestScore, bound, bestMove, ss->ply, rawEval, ttPv);
 
+    if (depth >= CLUSTER_TT_DEPTH && Cluster.sharing)
+      ClusterShareTT(board->zobrist, depth, bestScore, bound, bestMove, ss->ply, rawEval);
+  }
+
   if (!inCheck && !IsCap(bestMove) && (bound & (bestScore >= ss->staticEval ? BOUND_LOWER : BOUND_UPPER))) {
     UpdatePawnCorrection(ss->staticEval, bestScore, depth, board, thread);
     UpdateContCorrection(ss->staticEval, bestScore, depth, ss);
@@ -836,13 +1080,35 @@ int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV*
   return bestScore;
 }
 
-int Quiesce(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss) {
+// A PV window can shrink to a null window, so callers passing anything
+// other than an explicit null window dispatch through here
+int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, SearchStack* ss) {
+  if (beta - alpha == 1)
+    return NegamaxNonPV(alpha, beta, depth, cutnode, thread, ss);
+
+  return !ss->ply ? NegamaxRoot(alpha, beta, depth, cutnode, thread, ss) :
+                    NegamaxPV(alpha, beta, depth, cutnode, thread, ss);
+}
+
+static int NegamaxRoot(int alpha, int beta, int depth, int cutnode, ThreadData* thread, SearchStack* ss) {
+  return NegamaxNode(alpha, beta, depth, cutnode, thread, ss, NT_ROOT);
+}
+
+static int NegamaxPV(int alpha, int beta, int depth, int cutnode, ThreadData* thread, SearchStack* ss) {
+  return NegamaxNode(alpha, beta, depth, cutnode, thread, ss, NT_PV);
+}
+
+static int NegamaxNonPV(int alpha, int beta, int depth, int cutnode, ThreadData* thread, SearchStack* ss) {
+  return NegamaxNode(alpha, beta, depth, cutnode, thread, ss, NT_NON_PV);
+}
+
+INLINE int QuiesceNode(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss, const int nodeType) {
   Board* board = &thread->board;
 
   int score     = -CHECKMATE;
   int futility  = -CHECKMATE;
   int bestScore = -CHECKMATE + ss->ply;
-  int isPV      = beta - alpha != 1;
+  int isPV      = nodeType != NT_NON_PV;
   int inCheck   = !!board->checkers;
   int eval      = ss->staticEval;
   int rawEval   = eval;
@@ -852,8 +1118,7 @@ int Quiesce(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss)
   Move move     = NULL_MOVE;
 
   if (LoadRlx(Threads.stop) || (!thread->idx && CheckLimits(thread)))
-    // hot exit
-    longjmp(thread->exit, 1);
+    return 0;
 
   // draw check
   if (IsDraw(board, ss->ply))
@@ -934,12 +1199,12 @@ int Quiesce(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss)
     legalMoves++;
 
     if (bestScore > -TB_WIN_BOUND) {
-      if (!inCheck && mp.phase != QS_PLAY_QUIET_CHECKS && futility <= alpha && !SEE(board, move, 1)) {
+      if (!inCheck && mp.phase != QS_PLAY_QUIET_CHECKS && futility <= alpha && !PickedSEE(&mp, board, move, 1)) {
         bestScore = Max(bestScore, futility);
         continue;
       }
 
-      if (!SEE(board, move, 0))
+      if (!PickedSEE(&mp, board, move, 0))
         continue;
     }
 
@@ -949,16 +1214,20 @@ int Quiesce(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss)
       captures[numCaptures++] = move;
 
     TTPrefetch(KeyAfter(board, move));
-    ss->move = move;
-    ss->ch   = &thread->ch[IsCap(move)][Moving(move)][To(move)];
-    ss->cont = &thread->contCorrection[Moving(move)][To(move)];
-    IncRlx(thread->nodes);
+    ss->move  = move;
+    ss->piece = Moving(board, move);
+    SetContinuation(ss, thread, ss->piece, To(move), IsCap(move));
+    PrefetchContinuation(ss);
+    IncOwnRlx(thread->nodes);
     MakeMove(move, board);
 
     score = -Quiesce(-beta, -alpha, depth - 1, thread, ss + 1);
 
     UndoMove(move, board);
 
+    if (LoadRlx(Threads.stop))
+      return 0;
+
     if (score > -TB_WIN_BOUND)
       skipQuiets = 1;
 
@@ -990,7 +1259,26 @@ int Quiesce(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss)
   return bestScore;
 }
 
+int Quiesce(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss) {
+  if (beta - alpha == 1)
+    return QuiesceNonPV(alpha, beta, depth, thread, ss);
+
+  return QuiescePV(alpha, beta, depth, thread, ss);
+}
+
+static int QuiescePV(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss) {
+  return QuiesceNode(alpha, beta, depth, thread, ss, NT_PV);
+}
+
+static int QuiesceNonPV(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss) {
+  return QuiesceNode(alpha, beta, depth, thread, ss, NT_NON_PV);
+}
+
 void PrintUCI(ThreadData* thread, int alpha, int beta, Board* board) {
+  // Lines from the position before the opponent's move would confuse the GUI
+  if (Limits.ponderReplies)
+    return;
+
   int depth       = thread->depth;
   uint64_t nodes  = NodesSearched();
   uint64_t tbhits = TBHits();
@@ -1005,6 +1293,17 @@ void PrintUCI(ThreadData* thread, int alpha, int beta, Board* board) {
 
     int realDepth = updated ? depth : Max(1, depth - 1);
     int bounded   = updated ? Max(alpha, Min(beta, thread->rootMoves[i].score)) : thread->rootMoves[i].previousScore;
+
+    // Split lines complete independently, so each carries its own depth
+    if (Limits.splitMultiPV) {
+      if (!thread->rootMoves[i].depth)
+        break;
+
+      updated   = 0;
+      realDepth = thread->rootMoves[i].depth;
+      bounded   = thread->rootMoves[i].score;
+    }
+
     int printable = bounded > MATE_BOUND           ? (CHECKMATE - bounded + 1) / 2 :
                     bounded < -MATE_BOUND          ? -(CHECKMATE + bounded) / 2 :
                     abs(bounded) > TB_WIN_BOUND ? bounded : // don't normalize our fake tb scores or real tb scores
@@ -1079,18 +1378,28 @@ int ValidRootMove(ThreadData* thread, Move move) {
 void SearchClearThread(ThreadData* thread) {
   memset(&thread->counters, 0, sizeof(thread->counters));
   memset(&thread->hh, 0, sizeof(thread->hh));
-  memset(&thread->ch, 0, sizeof(thread->ch));
   memset(&thread->caph, 0, sizeof(thread->caph));
   memset(&thread->pawnCorrection, 0, sizeof(thread->pawnCorrection));
-  memset(&thread->contCorrection, 0, sizeof(thread->contCorrection));
+
+  // Continuation entries are emptied on use in a new epoch, so only the
+  // tags wrapping around need a real clear
+  if (!++thread->epoch) {
+    memset(&thread->continuation[0][0], 0, 12 * 64 * sizeof(ContinuationEntry));
+    memset(&thread->contEpoch, 0, sizeof(thread->contEpoch));
+  }
 
   thread->board.accumulators = thread->accumulators;
   thread->previousScore      = UNKNOWN;
 }
 
 void SearchClear() {
-  for (int i = 0; i < Threads.count; i++)
-    ThreadWake(Threads.threads[i], THREAD_SEARCH_CLEAR);
-  for (int i = 0; i < Threads.count; i++)
-    ThreadWaitUntilSleep(Threads.threads[i]);
+  ThreadsRun(SearchClearThread);
+}
+
+// The TT and continuation tables only start a new epoch, leaving the small
+// per thread tables as the only memory cleared up front
+void NewGameClear() {
+  TTClear();
+  SearchClear();
+  ClusterNewGame();
 }
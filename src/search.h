@@ -28,12 +28,20 @@
 #define TB_WIN_SCORE MATE_BOUND
 #define TB_WIN_BOUND (TB_WIN_SCORE - MAX_SEARCH_PLY)
 
+extern TABLE int LMR[MAX_SEARCH_PLY][64];
+extern TABLE int LMP[2][MAX_SEARCH_PLY];
+extern TABLE int STATIC_PRUNE[2][MAX_SEARCH_PLY];
+
 void InitPruningAndReductionTables();
 
 void StartSearch(Board* board, uint8_t ponder);
+void StopSearch();
+void StartPonderReplies(Board* board, Board* parent, int replies);
+void PonderHit(Board* board);
+void PonderResult(Board* board);
 void MainSearch();
 void Search(ThreadData* thread);
-int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, PV* pv, SearchStack* ss);
+int Negamax(int alpha, int beta, int depth, int cutnode, ThreadData* thread, SearchStack* ss);
 int Quiesce(int alpha, int beta, int depth, ThreadData* thread, SearchStack* ss);
 
 void PrintUCI(ThreadData* thread, int alpha, int beta, Board* board);
@@ -44,5 +52,6 @@ int ValidRootMove(ThreadData* thread, Move move);
 
 void SearchClearThread(ThreadData* thread);
 void SearchClear();
+void NewGameClear();
 
 #endif
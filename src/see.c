@@ -39,7 +39,7 @@ inline int SEE(Board* board, Move move, int threshold) {
   if (v < 0)
     return 0;
 
-  v = SEE_VALUE[PieceType(Moving(move))] - v;
+  v = SEE_VALUE[PieceType(Moving(board, move))] - v;
   if (v <= 0)
     return 1;
 
@@ -97,3 +97,96 @@ inline int SEE(Board* board, Move move, int threshold) {
 
   return result;
 }
+
+// Full exchange value of a capture, resolved with a swap list rather than
+// against a threshold. attackers holds every piece hitting the target with
+// the board's occupancy, so it can be shared by all captures on a square
+INLINE int SEEValue(Board* board, Move move, BitBoard attackers, const BitBoard diag, const BitBoard straight) {
+  if (IsCas(move) || IsEP(move) || IsPromo(move))
+    return SEE_PASS;
+
+  int from = From(move);
+  int to   = To(move);
+  int pt   = PieceType(board->squares[from]);
+
+  int stm      = board->stm;
+  BitBoard occ = OccBB(BOTH) ^ Bit(from) ^ Bit(to);
+  BitBoard mine, leastAttacker;
+
+  // Uncover anything lined up behind the moving piece
+  if (pt != KNIGHT)
+    attackers |= (Rank(from) == Rank(to) || File(from) == File(to)) ? GetRookAttacks(to, occ) & straight :
+                                                                      GetBishopAttacks(to, occ) & diag;
+
+  int gain[32];
+  int d           = 0;
+  int captorValue = SEE_VALUE[pt];
+
+  gain[0] = SEE_VALUE[PieceType(board->squares[to])];
+
+  while (1) {
+    stm ^= 1;
+    attackers &= occ;
+
+    if (!(mine = (attackers & OccBB(stm))))
+      break;
+
+    d++;
+    gain[d] = captorValue - gain[d - 1];
+
+    if ((leastAttacker = mine & PieceBB(PAWN, stm))) {
+      captorValue = SEE_VALUE[PAWN];
+      occ ^= (leastAttacker & -leastAttacker);
+      attackers |= GetBishopAttacks(to, occ) & diag;
+    } else if ((leastAttacker = mine & PieceBB(KNIGHT, stm))) {
+      captorValue = SEE_VALUE[KNIGHT];
+      occ ^= (leastAttacker & -leastAttacker);
+    } else if ((leastAttacker = mine & PieceBB(BISHOP, stm))) {
+      captorValue = SEE_VALUE[BISHOP];
+      occ ^= (leastAttacker & -leastAttacker);
+      attackers |= GetBishopAttacks(to, occ) & diag;
+    } else if ((leastAttacker = mine & PieceBB(ROOK, stm))) {
+      captorValue = SEE_VALUE[ROOK];
+      occ ^= (leastAttacker & -leastAttacker);
+      attackers |= GetRookAttacks(to, occ) & straight;
+    } else if ((leastAttacker = mine & PieceBB(QUEEN, stm))) {
+      captorValue = SEE_VALUE[QUEEN];
+      occ ^= (leastAttacker & -leastAttacker);
+      attackers |= (GetBishopAttacks(to, occ) & diag) | (GetRookAttacks(to, occ) & straight);
+    } else {
+      // The king can only take if nothing is left to take back
+      if (attackers & ~OccBB(stm))
+        d--;
+      break;
+    }
+  }
+
+  // Either side can stop the exchange when continuing would lose material
+  while (d > 0) {
+    gain[d - 1] = -Max(-gain[d - 1], gain[d]);
+    d--;
+  }
+
+  return gain[0];
+}
+
+// Score every move in a noisy list with its exchange value, computing
+// the attackers of each target square only once
+void SEEMoves(Board* board, ScoredMove* moves, ScoredMove* end) {
+  const BitBoard diag = PieceBB(BISHOP, WHITE) | PieceBB(BISHOP, BLACK) | PieceBB(QUEEN, WHITE) | PieceBB(QUEEN, BLACK);
+  const BitBoard straight = PieceBB(ROOK, WHITE) | PieceBB(ROOK, BLACK) | PieceBB(QUEEN, WHITE) | PieceBB(QUEEN, BLACK);
+
+  BitBoard attackers[64];
+  BitBoard seen = 0;
+
+  for (ScoredMove* curr = moves; curr != end; curr++) {
+    int to = To(curr->move);
+
+    if (!GetBit(seen, to)) {
+      attackers[to] = AttacksToSquare(board, to, OccBB(BOTH));
+      SetBit(seen, to);
+    }
+
+    curr->see = SEEValue(board, curr->move, attackers[to], diag, straight);
+  }
+}
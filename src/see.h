@@ -19,8 +19,14 @@
 
 #include "types.h"
 
+// Stored for moves the threshold SEE always passes (ep, castles, promotions)
+// and for the last picked move when it didn't come with an exchange value
+#define SEE_PASS    INT16_MAX
+#define SEE_UNKNOWN INT16_MIN
+
 extern const int SEE_VALUE[7];
 
 int SEE(Board* board, Move move, int threshold);
+void SEEMoves(Board* board, ScoredMove* moves, ScoredMove* end);
 
 #endif
\ No newline at end of file
@@ -28,7 +28,6 @@ INLINE Move TBMoveFromResult(unsigned res, Board* board) {
   unsigned to    = TB_GET_TO(res) ^ 56;
   unsigned ep    = TB_GET_EP(res);
   unsigned promo = TB_GET_PROMOTES(res);
-  int piece      = board->squares[from];
   int capture    = board->squares[to] != NO_PIECE;
 
   int flags = QUIET_FLAG;
@@ -46,7 +45,7 @@ INLINE Move TBMoveFromResult(unsigned res, Board* board) {
     }
   }
 
-  return BuildMove(from, to, piece, flags);
+  return BuildMove(from, to, flags);
 }
 
 void TBRootMoves(SimpleMoveList* moves, Board* board);
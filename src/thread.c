@@ -16,77 +16,133 @@
 
 #include "thread.h"
 
+#include <limits.h>
 #include <pthread.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "eval.h"
 #include "nn/accumulator.h"
 #include "search.h"
 #include "tb.h"
+#include "topology.h"
 #include "transposition.h"
 #include "types.h"
 #include "uci.h"
 #include "util.h"
 
-// Below is an implementation of CFish's Sleeping Threads
-// This is implemented entirely with pThreads
+// Sleeping threads wait on a pool wide generation counter, which every
+// wake bumps, and report back through their own action word. Both are
+// waited on by spinning briefly and then sleeping on a futex
 ThreadPool Threads;
 
-// Block until requested thread is sleeping
-void ThreadWaitUntilSleep(ThreadData* thread) {
-  pthread_mutex_lock(&thread->mutex);
+// Busy waiting rounds before sleeping in the kernel
+#define SPIN_COUNT 4096
+
+INLINE void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ volatile("yield");
+#endif
+}
 
-  while (thread->action != THREAD_SLEEP)
-    pthread_cond_wait(&thread->sleep, &thread->mutex);
+// Block while *word is old. Spinning is skipped when there are more threads
+// than cpus, where it would only steal time from the threads doing work
+void WaitWhileEqual(atomic_uint* word, unsigned old) {
+  if (Threads.spin)
+    for (int i = 0; i < SPIN_COUNT; i++) {
+      if (atomic_load(word) != old)
+        return;
+      CpuRelax();
+    }
 
-  pthread_mutex_unlock(&thread->mutex);
+#if defined(__linux__)
+  while (atomic_load(word) == old)
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, old, NULL, NULL, 0);
+#else
+  pthread_mutex_lock(&Threads.wakeLock);
+  while (atomic_load(word) == old)
+    pthread_cond_wait(&Threads.wakeCond, &Threads.wakeLock);
+  pthread_mutex_unlock(&Threads.wakeLock);
+#endif
+}
+
+// Wake everything in WaitWhileEqual on word, once it has been changed
+void WakeAll(atomic_uint* word) {
+#if defined(__linux__)
+  syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+  (void) word;
+  pthread_mutex_lock(&Threads.wakeLock);
+  pthread_cond_broadcast(&Threads.wakeCond);
+  pthread_mutex_unlock(&Threads.wakeLock);
+#endif
+}
+
+// Block until requested thread is sleeping
+void ThreadWaitUntilSleep(ThreadData* thread) {
+  unsigned action;
+  while ((action = atomic_load(&thread->action)) != THREAD_SLEEP)
+    WaitWhileEqual(&thread->action, action);
 
   if (thread->idx == 0)
     Threads.searching = 0;
 }
 
 // Block thread until on condition
-void ThreadWait(ThreadData* thread, atomic_uchar* cond) {
-  pthread_mutex_lock(&thread->mutex);
-
+void ThreadWait(atomic_uint* cond) {
   while (!atomic_load(cond))
-    pthread_cond_wait(&thread->sleep, &thread->mutex);
-
-  pthread_mutex_unlock(&thread->mutex);
+    WaitWhileEqual(cond, 0);
 }
 
-// Wake a thread up with an action
+// Wake a thread up with an action. THREAD_RESUME releases ThreadWait,
+// which is only ever used on Threads.stop
 void ThreadWake(ThreadData* thread, int action) {
-  pthread_mutex_lock(&thread->mutex);
+  if (action == THREAD_RESUME) {
+    WakeAll(&Threads.stop);
+    return;
+  }
 
-  if (action != THREAD_RESUME)
-    thread->action = action;
+  atomic_store(&thread->action, action);
+  atomic_fetch_add(&Threads.generation, 1);
+  WakeAll(&Threads.generation);
+}
+
+// Wake threads first and up into the same action, with a single bump. The
+// release store publishes everything set up for the action (boards, root
+// moves, Threads.task) to the thread that reads it back in ThreadIdle
+void ThreadsWake(int first, int action) {
+  for (int i = first; i < Threads.count; i++)
+    atomic_store_explicit(&Threads.threads[i]->action, action, memory_order_release);
 
-  pthread_cond_signal(&thread->sleep);
-  pthread_mutex_unlock(&thread->mutex);
+  atomic_fetch_add(&Threads.generation, 1);
+  WakeAll(&Threads.generation);
 }
 
 // Idle loop that wakes into an action
 void ThreadIdle(ThreadData* thread) {
   while (1) {
-    pthread_mutex_lock(&thread->mutex);
-
-    while (thread->action == THREAD_SLEEP) {
-      pthread_cond_signal(&thread->sleep);
-      pthread_cond_wait(&thread->sleep, &thread->mutex);
+    unsigned generation = atomic_load(&Threads.generation);
+    while (atomic_load(&thread->action) == THREAD_SLEEP) {
+      WaitWhileEqual(&Threads.generation, generation);
+      generation = atomic_load(&Threads.generation);
     }
 
-    pthread_mutex_unlock(&thread->mutex);
-
-    if (thread->action == THREAD_EXIT)
+    unsigned action = atomic_load_explicit(&thread->action, memory_order_acquire);
+    if (action == THREAD_EXIT)
       break;
-    else if (thread->action == THREAD_TT_CLEAR) {
-      TTClearPart(thread->idx);
-    } else if (thread->action == THREAD_SEARCH_CLEAR) {
-      SearchClearThread(thread);
+    else if (action == THREAD_TASK) {
+      Threads.task(thread);
     } else {
       if (thread->idx)
         Search(thread);
@@ -94,7 +150,8 @@ void ThreadIdle(ThreadData* thread) {
         MainSearch();
     }
 
-    thread->action = THREAD_SLEEP;
+    atomic_store(&thread->action, THREAD_SLEEP);
+    WakeAll(&thread->action);
   }
 }
 
@@ -102,8 +159,17 @@ void ThreadIdle(ThreadData* thread) {
 void* ThreadInit(void* arg) {
   int i = (intptr_t) arg;
 
-  ThreadData* thread = calloc(1, sizeof(ThreadData));
-  thread->idx        = i;
+  // Pin first, so everything below is allocated and first touched
+  // on the node this thread runs on
+  PinThread(pthread_self(), i, Threads.pin);
+
+  ThreadData* thread = AlignedMalloc(sizeof(ThreadData), ALIGN_ON);
+  memset(thread, 0, sizeof(ThreadData));
+  thread->idx = i;
+
+#if defined(LOW_MEMORY)
+  thread->continuation = calloc(12 * 64, sizeof(ContinuationEntry));
+#endif
 
 #if defined(__linux__)
   const size_t alignment = MEGABYTE * 2;
@@ -113,6 +179,7 @@ void* ThreadInit(void* arg) {
 
   // Alloc all the necessary accumulators
   thread->accumulators = (Accumulator*) AlignedMalloc(sizeof(Accumulator) * (MAX_SEARCH_PLY + 1), alignment);
+  memset(thread->accumulators, 0, sizeof(Accumulator) * (MAX_SEARCH_PLY + 1));
   thread->refreshTable =
     (AccumulatorKingState*) AlignedMalloc(sizeof(AccumulatorKingState) * 2 * 2 * N_KING_BUCKETS, alignment);
   ResetRefreshTable(thread->refreshTable);
@@ -121,14 +188,12 @@ void* ThreadInit(void* arg) {
   thread->board.accumulators = thread->accumulators;
   thread->board.refreshTable = thread->refreshTable;
 
-  pthread_mutex_init(&thread->mutex, NULL);
-  pthread_cond_init(&thread->sleep, NULL);
-
-  Threads.threads[i] = thread;
+  thread->nativeThread = pthread_self();
+  Threads.threads[i]   = thread;
 
   pthread_mutex_lock(&Threads.mutex);
-  Threads.init = 0;
-  pthread_cond_signal(&Threads.sleep);
+  if (!--Threads.init)
+    pthread_cond_signal(&Threads.sleep);
   pthread_mutex_unlock(&Threads.mutex);
 
   ThreadIdle(thread);
@@ -136,64 +201,181 @@ void* ThreadInit(void* arg) {
   return NULL;
 }
 
-// Create a thread with idx i
+// Start a thread with idx i, ThreadsWaitForInit waits for it to be ready
 void ThreadCreate(int i) {
   pthread_t thread;
 
-  Threads.init = 1;
   pthread_mutex_lock(&Threads.mutex);
+  Threads.init++;
+  pthread_mutex_unlock(&Threads.mutex);
+
   pthread_create(&thread, NULL, ThreadInit, (void*) (intptr_t) i);
+}
 
+// Block until every started thread has built its tables
+static void ThreadsWaitForInit() {
+  pthread_mutex_lock(&Threads.mutex);
   while (Threads.init)
     pthread_cond_wait(&Threads.sleep, &Threads.mutex);
   pthread_mutex_unlock(&Threads.mutex);
-
-  Threads.threads[i]->nativeThread = thread;
 }
 
 // Teardown and free a thread
 void ThreadDestroy(ThreadData* thread) {
-  pthread_mutex_lock(&thread->mutex);
-  thread->action = THREAD_EXIT;
-  pthread_cond_signal(&thread->sleep);
-  pthread_mutex_unlock(&thread->mutex);
-
+  ThreadWake(thread, THREAD_EXIT);
   pthread_join(thread->nativeThread, NULL);
-  pthread_cond_destroy(&thread->sleep);
-  pthread_mutex_destroy(&thread->mutex);
 
   AlignedFree(thread->accumulators);
   AlignedFree(thread->refreshTable);
 
-  free(thread);
+#if defined(LOW_MEMORY)
+  free(thread->continuation);
+#endif
+
+  AlignedFree(thread);
 }
 
 // Build the pool to a certain amnt
 void ThreadsSetNumber(int n) {
+  int pin = ShouldPin(n);
+
+  // Threads started under the other setting first touched their tables
+  // wherever they ran, so all of them are rebuilt rather than moved
+  int keep = pin == Threads.pin ? n : 0;
+
+  // Tell every removed thread to exit before joining any
+  ThreadsWake(keep, THREAD_EXIT);
+  while (Threads.count > keep)
+    ThreadDestroy(Threads.threads[--Threads.count]);
+
+  Threads.pin  = pin;
+  Threads.spin = n < CpuCount();
+
+  // New threads allocate and clear their own tables, all at once
   while (Threads.count < n)
     ThreadCreate(Threads.count++);
-  while (Threads.count > n)
-    ThreadDestroy(Threads.threads[--Threads.count]);
+  ThreadsWaitForInit();
 
   if (n == 0)
     Threads.searching = 0;
 }
 
+// Run a task on every thread in parallel, returning once all have finished
+void ThreadsRun(void (*task)(ThreadData* thread)) {
+  Threads.task = task;
+
+  ThreadsWake(0, THREAD_TASK);
+  for (int i = 0; i < Threads.count; i++)
+    ThreadWaitUntilSleep(Threads.threads[i]);
+}
+
+// Pin (or unpin) every thread after the option changes
+void ThreadsPin() {
+  if (ShouldPin(Threads.count) != Threads.pin)
+    ThreadsSetNumber(Threads.count);
+}
+
+// Bytes allocated for each search thread
+uint64_t ThreadMemory() {
+  uint64_t bytes = sizeof(ThreadData) +                                   //
+                   sizeof(Accumulator) * (MAX_SEARCH_PLY + 1) +           //
+                   sizeof(AccumulatorKingState) * 2 * 2 * N_KING_BUCKETS; //
+
+#if defined(LOW_MEMORY)
+  bytes += 12 * 64 * sizeof(ContinuationEntry);
+#endif
+
+  return bytes;
+}
+
 // End
 void ThreadsExit() {
   ThreadsSetNumber(0);
 
   pthread_cond_destroy(&Threads.sleep);
   pthread_mutex_destroy(&Threads.mutex);
+  pthread_mutex_destroy(&Threads.splitLock);
+  pthread_cond_destroy(&Threads.timerSleep);
+  pthread_mutex_destroy(&Threads.timerLock);
+  pthread_cond_destroy(&Threads.wakeCond);
+  pthread_mutex_destroy(&Threads.wakeLock);
 }
 
 // Start
 void ThreadsInit() {
   pthread_mutex_init(&Threads.mutex, NULL);
+  pthread_mutex_init(&Threads.splitLock, NULL);
+  pthread_mutex_init(&Threads.timerLock, NULL);
+  pthread_cond_init(&Threads.timerSleep, NULL);
   pthread_cond_init(&Threads.sleep, NULL);
+  pthread_mutex_init(&Threads.wakeLock, NULL);
+  pthread_cond_init(&Threads.wakeCond, NULL);
 
   Threads.count = 1;
+  Threads.spin  = CpuCount() > 1;
   ThreadCreate(0);
+  ThreadsWaitForInit();
+}
+
+// Sleep until the hard limit of the search, then raise stop.
+// While pondering the deadline is ignored until a ponderhit wakes us.
+void* TimerLoop(void* arg) {
+  (void) arg;
+
+  pthread_mutex_lock(&Threads.timerLock);
+
+  while (Threads.timerActive) {
+    if (Threads.stop || Threads.ponder) {
+      pthread_cond_wait(&Threads.timerSleep, &Threads.timerLock);
+      continue;
+    }
+
+    long remaining = Limits.start + Limits.max - GetTimeMS();
+    if (remaining <= 0) {
+      Threads.stop = 1;
+      continue;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += remaining / 1000;
+    deadline.tv_nsec += (remaining % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
+      deadline.tv_sec++, deadline.tv_nsec -= 1000000000;
+
+    pthread_cond_timedwait(&Threads.timerSleep, &Threads.timerLock, &deadline);
+  }
+
+  pthread_mutex_unlock(&Threads.timerLock);
+
+  return NULL;
+}
+
+void TimerStart() {
+  if (!Limits.timeset)
+    return;
+
+  Threads.timerActive = 1;
+  pthread_create(&Threads.timer, NULL, TimerLoop, NULL);
+}
+
+// Re-evaluate the deadline, used on ponderhit
+void TimerWake() {
+  pthread_mutex_lock(&Threads.timerLock);
+  pthread_cond_signal(&Threads.timerSleep);
+  pthread_mutex_unlock(&Threads.timerLock);
+}
+
+void TimerStop() {
+  if (!Threads.timerActive)
+    return;
+
+  pthread_mutex_lock(&Threads.timerLock);
+  Threads.timerActive = 0;
+  pthread_cond_signal(&Threads.timerSleep);
+  pthread_mutex_unlock(&Threads.timerLock);
+
+  pthread_join(Threads.timer, NULL);
 }
 
 INLINE void InitRootMove(RootMove* rm, Move move) {
@@ -204,7 +386,7 @@ INLINE void InitRootMove(RootMove* rm, Move move) {
   rm->pv.moves[0] = move;
   rm->pv.count    = 1;
 
-  rm->nodes = 0;
+  rm->nodes = rm->depth = 0;
 }
 
 void SetupMainThread(Board* board) {
@@ -214,7 +396,7 @@ void SetupMainThread(Board* board) {
   mainThread->tbhits     = 0;
   mainThread->nmpMinPly  = 0;
 
-  memcpy(&mainThread->board, board, offsetof(Board, accumulators));
+  CopyBoard(&mainThread->board, board);
 
   if (Limits.searchMoves) {
     for (int i = 0; i < Limits.searchable.count; i++)
@@ -233,6 +415,11 @@ void SetupMainThread(Board* board) {
 
     mainThread->numRootMoves = ml->count;
   }
+
+  if (Limits.splitMultiPV) {
+    memcpy(Threads.splitMoves, mainThread->rootMoves, mainThread->numRootMoves * sizeof(RootMove));
+    Threads.numSplitMoves = mainThread->numRootMoves;
+  }
 }
 
 void SetupOtherThreads(Board* board) {
@@ -250,10 +437,104 @@ void SetupOtherThreads(Board* board) {
 
     thread->numRootMoves = mainThread->numRootMoves;
 
-    memcpy(&thread->board, board, offsetof(Board, accumulators));
+    CopyBoard(&thread->board, board);
   }
 }
 
+// Split MultiPV - reorder this thread's root moves to match the merged
+// results of all threads, so the lines before thread->multiPV are excluded.
+// Node counts are kept per thread as they drive time management.
+static void CopySplitMoves(ThreadData* thread) {
+  for (int i = 0; i < Threads.numSplitMoves; i++) {
+    RootMove* shared = &Threads.splitMoves[i];
+
+    for (int j = i; j < thread->numRootMoves; j++) {
+      if (thread->rootMoves[j].move != shared->move)
+        continue;
+
+      RootMove temp        = thread->rootMoves[j];
+      thread->rootMoves[j] = thread->rootMoves[i];
+      thread->rootMoves[i] = temp;
+      break;
+    }
+
+    RootMove* rm      = &thread->rootMoves[i];
+    rm->depth         = shared->depth;
+    rm->seldepth      = shared->seldepth;
+    rm->score         = shared->score;
+    rm->previousScore = shared->previousScore;
+    rm->avgScore      = shared->avgScore;
+    rm->pv.count      = shared->pv.count;
+    memcpy(rm->pv.moves, shared->pv.moves, shared->pv.count * sizeof(Move));
+  }
+}
+
+void SyncRootMoves(ThreadData* thread) {
+  pthread_mutex_lock(&Threads.splitLock);
+  CopySplitMoves(thread);
+  pthread_mutex_unlock(&Threads.splitLock);
+}
+
+// Split MultiPV - pick a line that hasn't been completed at this thread's depth.
+// Threads start from different lines and pick up any left over by the others,
+// returning Limits.multiPV once every line is done.
+int NextSplitLine(ThreadData* thread) {
+  int line = Limits.multiPV;
+
+  pthread_mutex_lock(&Threads.splitLock);
+  CopySplitMoves(thread);
+
+  for (int n = 0; n < Limits.multiPV; n++) {
+    int i = (thread->idx + n) % Limits.multiPV;
+
+    if (Threads.splitMoves[i].depth < thread->depth) {
+      line = i;
+      break;
+    }
+  }
+
+  pthread_mutex_unlock(&Threads.splitLock);
+
+  return line;
+}
+
+INLINE int SplitLineBefore(RootMove* a, RootMove* b) {
+  return a->depth > b->depth || (a->depth == b->depth && a->score > b->score);
+}
+
+// Split MultiPV - merge the line this thread just completed into the shared
+// results. Deeper results always win, then lines are ordered by score.
+void PublishRootMove(ThreadData* thread) {
+  RootMove* rm = &thread->rootMoves[thread->multiPV];
+
+  pthread_mutex_lock(&Threads.splitLock);
+
+  int i = 0;
+  while (i < Threads.numSplitMoves && Threads.splitMoves[i].move != rm->move)
+    i++;
+
+  RootMove* shared = &Threads.splitMoves[i];
+  if (i < Threads.numSplitMoves && thread->depth >= shared->depth) {
+    shared->previousScore = shared->score;
+    shared->depth         = thread->depth;
+    shared->seldepth      = rm->seldepth;
+    shared->score         = rm->score;
+    shared->avgScore      = rm->avgScore;
+    shared->pv.count      = rm->pv.count;
+    memcpy(shared->pv.moves, rm->pv.moves, rm->pv.count * sizeof(Move));
+
+    // the other lines remain sorted, so only the updated one has to move
+    RootMove temp = *shared;
+    for (; i > 0 && SplitLineBefore(&temp, &Threads.splitMoves[i - 1]); i--)
+      Threads.splitMoves[i] = Threads.splitMoves[i - 1];
+    for (; i < Threads.numSplitMoves - 1 && SplitLineBefore(&Threads.splitMoves[i + 1], &temp); i++)
+      Threads.splitMoves[i] = Threads.splitMoves[i + 1];
+    Threads.splitMoves[i] = temp;
+  }
+
+  pthread_mutex_unlock(&Threads.splitLock);
+}
+
 // sum node counts
 uint64_t NodesSearched() {
   uint64_t nodes = 0;
@@ -29,26 +29,62 @@ typedef struct {
   pthread_mutex_t mutex, lock;
   pthread_cond_t sleep;
 
-  uint8_t init, searching, sleeping, stopOnPonderHit;
-  atomic_uchar ponder, stop;
+  void (*task)(ThreadData* thread); // run by every thread for THREAD_TASK
+
+  int init; // threads started but not yet ready
+  uint8_t searching, sleeping, stopOnPonderHit;
+  uint8_t pin;  // threads are pinned to cpus, see topology.c
+  uint8_t spin; // idle threads spin before sleeping, when each (and the uci thread) has a cpu
+  atomic_uchar ponder;
+  atomic_uint stop;
+
+  // Bumped on every wake, idle threads wait for it to change
+  atomic_uint generation;
+  pthread_mutex_t wakeLock; // stands in for futexes off Linux
+  pthread_cond_t wakeCond;
+
+  // Merged root moves for split MultiPV, ordered by depth then score
+  pthread_mutex_t splitLock;
+  int numSplitMoves;
+  RootMove splitMoves[MAX_MOVES];
+
+  // Watchdog enforcing the hard time limit, so searching threads only read stop
+  pthread_t timer;
+  pthread_mutex_t timerLock;
+  pthread_cond_t timerSleep;
+  uint8_t timerActive;
 } ThreadPool;
 
 extern ThreadPool Threads;
 
+void WaitWhileEqual(atomic_uint* word, unsigned old);
+void WakeAll(atomic_uint* word);
 void ThreadWaitUntilSleep(ThreadData* thread);
-void ThreadWait(ThreadData* thread, atomic_uchar* cond);
+void ThreadWait(atomic_uint* cond);
 void ThreadWake(ThreadData* thread, int action);
+void ThreadsWake(int first, int action);
 void ThreadIdle(ThreadData* thread);
 void* ThreadInit(void* arg);
 void ThreadCreate(int i);
 void ThreadDestroy(ThreadData* thread);
 void ThreadsSetNumber(int n);
+void ThreadsRun(void (*task)(ThreadData* thread));
+void ThreadsPin();
+uint64_t ThreadMemory();
 void ThreadsExit();
 void ThreadsInit();
 
+void TimerStart();
+void TimerWake();
+void TimerStop();
+
 void SetupMainThread(Board* board);
 void SetupOtherThreads(Board* board);
 
+void SyncRootMoves(ThreadData* thread);
+int NextSplitLine(ThreadData* thread);
+void PublishRootMove(ThreadData* thread);
+
 uint64_t NodesSearched();
 uint64_t TBHits();
 
@@ -0,0 +1,175 @@
+// Berserk is a UCI compliant chess engine written in C
+// Copyright (C) 2024 Jay Honnold
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include "topology.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+#include "thread.h"
+#include "util.h"
+
+int THREAD_PINNING = 1;
+
+typedef struct {
+  int cpu, node, package, core;
+  int smt; // 0 for the first cpu of a physical core, 1 for its sibling...
+} CPU;
+
+// The cpus this process may run on, in the order threads are placed:
+// every physical core (node by node) before any SMT sibling
+static CPU cpus[MAX_CPUS];
+static int numCpus, numCores, numNodes;
+
+#if defined(__linux__)
+static cpu_set_t processMask;
+
+static int ReadInt(const char* fmt, int cpu, int fallback) {
+  char path[128];
+  snprintf(path, sizeof(path), fmt, cpu);
+
+  FILE* fin = fopen(path, "r");
+  if (fin == NULL)
+    return fallback;
+
+  int value = fallback;
+  if (fscanf(fin, "%d", &value) != 1)
+    value = fallback;
+
+  fclose(fin);
+  return value;
+}
+
+// A cpu's NUMA node shows up as a nodeN entry in its sysfs directory
+static int CpuNode(int cpu) {
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+
+  DIR* dir = opendir(path);
+  if (dir == NULL)
+    return 0;
+
+  int node = 0;
+  struct dirent* entry;
+  while ((entry = readdir(dir)))
+    if (!strncmp(entry->d_name, "node", 4) && sscanf(entry->d_name + 4, "%d", &node) == 1)
+      break;
+
+  closedir(dir);
+  return node;
+}
+
+static int CompareCPU(const void* a, const void* b) {
+  const CPU* x = a;
+  const CPU* y = b;
+
+  if (x->smt != y->smt)
+    return x->smt - y->smt;
+  if (x->node != y->node)
+    return x->node - y->node;
+  if (x->package != y->package)
+    return x->package - y->package;
+  if (x->core != y->core)
+    return x->core - y->core;
+  return x->cpu - y->cpu;
+}
+#endif
+
+// Discover nodes, physical cores and SMT siblings from /sys, limited to
+// the cpus in this process's affinity mask
+void TopologyInit() {
+#if defined(__linux__)
+  if (sched_getaffinity(0, sizeof(processMask), &processMask))
+    return;
+
+  for (int cpu = 0; cpu < MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, &processMask))
+      continue;
+
+    CPU* c     = &cpus[numCpus++];
+    c->cpu     = cpu;
+    c->node    = CpuNode(cpu);
+    c->package = ReadInt("/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu, 0);
+    c->core    = ReadInt("/sys/devices/system/cpu/cpu%d/topology/core_id", cpu, cpu);
+    c->smt     = 0;
+
+    for (int i = 0; i < numCpus - 1; i++)
+      if (cpus[i].node == c->node && cpus[i].package == c->package && cpus[i].core == c->core)
+        c->smt++;
+
+    numCores += !c->smt;
+    numNodes = Max(numNodes, c->node + 1);
+  }
+
+  qsort(cpus, numCpus, sizeof(CPU), CompareCPU);
+#endif
+}
+
+// Cpus available to this process, 1 where they can't be discovered
+int CpuCount() {
+  return Max(1, numCpus);
+}
+
+// Only a pool that covers most of the cpus is pinned. Smaller ones are left
+// to the scheduler, so several engines on one machine don't all end up on
+// the first few cpus
+int ShouldPin(int numThreads) {
+  return THREAD_PINNING && numCpus > 1 && numThreads > 1 && 2 * numThreads > numCpus;
+}
+
+// Pin thread idx to its cpu, or let it run anywhere in the process mask
+void PinThread(pthread_t thread, int idx, int pin) {
+#if defined(__linux__)
+  if (!numCpus)
+    return;
+
+  cpu_set_t mask = processMask;
+  if (pin) {
+    CPU_ZERO(&mask);
+    CPU_SET(cpus[idx % numCpus].cpu, &mask);
+  }
+
+  pthread_setaffinity_np(thread, sizeof(mask), &mask);
+#else
+  (void) thread;
+  (void) idx;
+  (void) pin;
+#endif
+}
+
+void PrintTopology() {
+  printf("info string %d cpus, %d physical cores, %d nodes\n", numCpus, numCores, numNodes);
+
+  for (int i = 0; i < Threads.count; i++) {
+    if (!Threads.pin) {
+      printf("info string thread %d not pinned\n", i);
+      continue;
+    }
+
+    CPU* c = &cpus[i % numCpus];
+    printf("info string thread %d cpu %d node %d core %d%s\n", i, c->cpu, c->node, c->core, c->smt ? " smt" : "");
+  }
+}
@@ -17,12 +17,17 @@
 #include <inttypes.h>
 #include <math.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#if defined(__linux__)
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include "bits.h"
@@ -36,12 +41,98 @@ const int DEPTH_OFFSET = -2;
 // Global TT
 TTTable TT = {0};
 
+// Leads a shared table, the buckets start SHARED_HEADER bytes in
+typedef struct TTShared {
+  atomic_uint ready; // cleared by the process that created it
+  atomic_uint users; // attached processes, the last to leave unlinks it
+  atomic_uint age;
+  atomic_uint epoch;
+} TTShared;
+
+#define SHARED_HEADER 4096
+
+#if !defined(_WIN32)
+// Attach to the segment named TT.name, creating it when missing. An existing
+// segment keeps its size, so every process indexes the same buckets
+static int TTMapShared(uint64_t size) {
+  int created = 1;
+  int fd      = shm_open(TT.name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0 && errno == EEXIST) {
+    created = 0;
+    fd      = shm_open(TT.name, O_RDWR, 0600);
+  }
+
+  if (fd < 0)
+    return 0;
+
+  if (created && ftruncate(fd, SHARED_HEADER + size)) {
+    close(fd);
+    shm_unlink(TT.name);
+    return 0;
+  }
+
+  // The creator may not have sized it yet
+  struct stat st;
+  for (int i = 0; i < 500 && !fstat(fd, &st) && st.st_size <= SHARED_HEADER; i++)
+    usleep(10000);
+
+  if (fstat(fd, &st) || st.st_size <= SHARED_HEADER) {
+    close(fd);
+    return 0;
+  }
+
+  void* mem = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (mem == MAP_FAILED)
+    return 0;
+
+#if defined(MADV_HUGEPAGE)
+  madvise(mem, st.st_size, MADV_HUGEPAGE);
+#endif
+
+  TT.mem     = mem;
+  TT.mapped  = st.st_size;
+  TT.shared  = mem;
+  TT.buckets = (TTBucket*) ((char*) mem + SHARED_HEADER);
+  TT.count   = (st.st_size - SHARED_HEADER) / sizeof(TTBucket);
+
+  if (created) {
+    // Already zero, cleared again so each thread first touches its part
+    TT.epoch = 0;
+    ThreadsRun(TTClearPart);
+    atomic_store(&TT.shared->ready, 1);
+  } else {
+    for (int i = 0; i < 1000 && !atomic_load(&TT.shared->ready); i++)
+      usleep(10000);
+  }
+
+  atomic_fetch_add(&TT.shared->users, 1);
+  TT.age   = atomic_load(&TT.shared->age);
+  TT.epoch = atomic_load(&TT.shared->epoch);
+  return 1;
+}
+#else
+static int TTMapShared(uint64_t size) {
+  (void) size;
+  return 0;
+}
+#endif
+
 size_t TTInit(int mb) {
   if (TT.mem)
     TTFree();
 
   uint64_t size = (uint64_t) mb * MEGABYTE;
 
+  if (TT.name[0]) {
+    if (TTMapShared(size))
+      return TT.count * sizeof(TTBucket);
+
+    printf("info string unable to share hash as %s, using a private table\n", TT.name);
+    TT.name[0] = '\0';
+  }
+
 #if defined(__linux__)
   const size_t alignment = 2 * MEGABYTE;
 #else
@@ -56,16 +147,45 @@ size_t TTInit(int mb) {
 
   TT.buckets = (TTBucket*) TT.mem;
   TT.count   = size / sizeof(TTBucket);
+  TT.epoch   = 0;
 
-  TTClear();
+  ThreadsRun(TTClearPart);
   return size;
 }
 
+// Move the table into the named shared segment, or back to private memory
+// for NULL, keeping the current size
+size_t TTShare(char* name) {
+  int mb = TT.count * sizeof(TTBucket) / MEGABYTE;
+
+  TTFree();
+  if (name == NULL)
+    TT.name[0] = '\0';
+  else
+    snprintf(TT.name, sizeof(TT.name), "%s%s", name[0] == '/' ? "" : "/", name);
+
+  return TTInit(Max(2, mb));
+}
+
 void TTFree() {
+#if !defined(_WIN32)
+  if (TT.shared) {
+    if (atomic_fetch_sub(&TT.shared->users, 1) == 1)
+      shm_unlink(TT.name);
+
+    munmap(TT.mem, TT.mapped);
+    TT.shared = NULL;
+    TT.mem    = NULL;
+    return;
+  }
+#endif
+
   AlignedFree(TT.mem);
+  TT.mem = NULL;
 }
 
-void TTClearPart(int idx) {
+void TTClearPart(ThreadData* thread) {
+  int idx   = thread->idx;
   int count = Threads.count;
 
   const uint64_t size   = TT.count * sizeof(TTBucket);
@@ -77,15 +197,26 @@ void TTClearPart(int idx) {
   memset(TT.buckets + begin / sizeof(TTBucket), 0, end - begin);
 }
 
+// Clearing only starts a new epoch, buckets from an older one are emptied
+// when they are next probed. The table is wiped for real once the tags wrap
 inline void TTClear() {
-  for (int i = 0; i < Threads.count; i++)
-    ThreadWake(Threads.threads[i], THREAD_TT_CLEAR);
-  for (int i = 0; i < Threads.count; i++)
-    ThreadWaitUntilSleep(Threads.threads[i]);
+  if (TT.shared)
+    TT.epoch = atomic_fetch_add(&TT.shared->epoch, 1) + 1;
+  else
+    ++TT.epoch;
+
+  if (!TT.epoch)
+    ThreadsRun(TTClearPart);
 }
 
+// A shared table ages with the searches of every process, and picks up any
+// clear another process made since
 inline void TTUpdate() {
-  TT.age += AGE_INC;
+  if (TT.shared) {
+    TT.age   = atomic_fetch_add(&TT.shared->age, AGE_INC) + AGE_INC;
+    TT.epoch = atomic_load(&TT.shared->epoch);
+  } else
+    TT.age += AGE_INC;
 }
 
 inline uint64_t TTIdx(uint64_t hash) {
@@ -105,11 +236,23 @@ inline TTEntry* TTProbe(uint64_t hash,
                         int* ttDepth,
                         int* ttBound,
                         int* pv) {
-  TTEntry* const bucket    = TT.buckets[TTIdx(hash)].entries;
-  const uint16_t shortHash = (uint16_t) hash;
+  TTBucket* const b = &TT.buckets[TTIdx(hash)];
+  if (b->epoch != TT.epoch) {
+    // In a shared table the bucket may carry a newer epoch another process
+    // started mid search, follow it instead of wiping its entries
+    if (TT.shared)
+      TT.epoch = atomic_load_explicit(&TT.shared->epoch, memory_order_relaxed);
+
+    if (b->epoch != TT.epoch) {
+      memset(b->entries, 0, sizeof(b->entries));
+      b->epoch = TT.epoch;
+    }
+  }
+
+  TTEntry* const bucket = b->entries;
 
   for (int i = 0; i < BUCKET_SIZE; i++) {
-    if (bucket[i].hash == shortHash || !bucket[i].depth) {
+    if (TTMatch(&bucket[i], hash) || !bucket[i].depth) {
       *hit = !!bucket[i].depth;
 
       if (*hit) {
@@ -137,18 +280,18 @@ inline TTEntry* TTProbe(uint64_t hash,
 
 inline void
 TTPut(TTEntry* tt, uint64_t hash, int depth, int16_t score, uint8_t bound, Move move, int ply, int16_t eval, int pv) {
-  uint16_t shortHash = (uint16_t) hash;
+  int match = TTMatch(tt, hash);
 
   if (score >= TB_WIN_BOUND)
     score += ply;
   else if (score <= -TB_WIN_BOUND)
     score -= ply;
 
-  if (move || shortHash != tt->hash)
+  if (move || !match)
     TTStoreMove(tt, move);
 
-  if ((bound == BOUND_EXACT) || shortHash != tt->hash || depth + 4 > TTDepth(tt) || TTAge(tt)) {
-    tt->hash       = shortHash;
+  if ((bound == BOUND_EXACT) || !match || depth + 4 > TTDepth(tt) || TTAge(tt)) {
+    TTStoreKey(tt, hash);
     tt->score      = score;
     tt->depth      = (uint8_t) (depth - DEPTH_OFFSET);
     tt->agePvBound = (uint8_t) (TT.age | (pv << 2) | bound);
@@ -160,7 +303,7 @@ int TTFull() {
   int c = 0;
 
   for (int i = 0; i < 1000; i++)
-    for (int j = 0; j < BUCKET_SIZE; j++)
+    for (int j = 0; j < BUCKET_SIZE && TT.buckets[i].epoch == TT.epoch; j++)
       c += TT.buckets[i].entries[j].depth && (TT.buckets[i].entries[j].agePvBound & AGE_MASK) == TT.age;
 
   return c / BUCKET_SIZE;
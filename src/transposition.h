@@ -40,7 +40,7 @@ typedef struct __attribute__((packed)) {
 
 typedef struct {
   TTEntry entries[BUCKET_SIZE];
-  uint16_t padding;
+  uint16_t epoch; // entries written in an older epoch were cleared since
 } TTBucket;
 
 typedef struct {
@@ -48,6 +48,13 @@ typedef struct {
   TTBucket* buckets;
   uint64_t count;
   uint8_t age;
+  uint16_t epoch;
+
+  // Set when the table lives in a named shared memory segment, where age
+  // and epoch are kept in a header every attached process updates
+  struct TTShared* shared;
+  size_t mapped;
+  char name[256];
 } TTTable;
 
 enum {
@@ -60,8 +67,9 @@ enum {
 extern TTTable TT;
 
 size_t TTInit(int mb);
+size_t TTShare(char* name);
 void TTFree();
-void TTClearPart(int idx);
+void TTClearPart(ThreadData* thread);
 void TTClear();
 void TTUpdate();
 void TTPrefetch(uint64_t hash);
@@ -92,8 +100,13 @@ INLINE int TTAge(TTEntry* e) {
 }
 
 INLINE Move TTMove(TTEntry* e) {
-  // Lower 20 bits for move
-  return (e->evalAndMove & 0xfffff);
+  // Lower 16 bits for move
+  return (e->evalAndMove & 0xffff);
+}
+
+INLINE int TTMatch(TTEntry* e, uint64_t hash) {
+  // 16 bits of key in hash, 4 more in the bits a 16 bit move frees up
+  return e->hash == (uint16_t) hash && (e->evalAndMove & 0x000f0000) == (hash & 0x000f0000);
 }
 
 INLINE int TTEval(TTEntry* e) {
@@ -102,7 +115,12 @@ INLINE int TTEval(TTEntry* e) {
 }
 
 INLINE void TTStoreMove(TTEntry* e, Move move) {
-  e->evalAndMove = (e->evalAndMove & 0xfff00000) | move;
+  e->evalAndMove = (e->evalAndMove & 0xffff0000) | move;
+}
+
+INLINE void TTStoreKey(TTEntry* e, uint64_t hash) {
+  e->hash        = (uint16_t) hash;
+  e->evalAndMove = (e->evalAndMove & 0xfff0ffff) | (hash & 0x000f0000);
 }
 
 INLINE void TTStoreEval(TTEntry* e, int eval) {
@@ -20,7 +20,6 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <pthread.h>
-#include <setjmp.h>
 #include <stdatomic.h>
 
 #define MAX_SEARCH_PLY 201 // effective max depth 250
@@ -38,14 +37,32 @@
 #define ALIGN_ON 64
 #define ALIGN    __attribute__((aligned(ALIGN_ON)))
 
+// Lookup tables are filled in at startup, unless they were generated
+// ahead of time with `make prebuilt` and compiled in as read-only data
+#ifdef PREBUILT_TABLES
+#define TABLE const
+#else
+#define TABLE
+#endif
+
+// LOW_MEMORY trims the per instance footprint for hosting many small
+// engines on one box, see the README
+#if defined(LOW_MEMORY) && defined(PREBUILT_TABLES)
+#define SHARED_WEIGHTS
+#endif
+
 #define CORRECTION_GRAIN 256
 
+#if defined(LOW_MEMORY)
+#define PAWN_CORRECTION_SIZE 16384
+#else
 #define PAWN_CORRECTION_SIZE 131072
+#endif
 #define PAWN_CORRECTION_MASK (PAWN_CORRECTION_SIZE - 1)
 
 typedef int Score;
 typedef uint64_t BitBoard;
-typedef uint32_t Move;
+typedef uint16_t Move;
 
 enum {
   SUB = 0,
@@ -58,6 +75,7 @@ typedef struct {
   uint8_t correct[2];
   uint16_t captured;
   Move move;
+  uint16_t moving;
   acc_t values[2][N_HIDDEN] ALIGN;
 } Accumulator;
 
@@ -71,6 +89,7 @@ typedef struct {
   int ep;
   int fmr;
   int nullply;
+  int threatsReady;
   uint64_t zobrist;
   uint64_t pawnZobrist;
   BitBoard checkers;
@@ -88,6 +107,8 @@ typedef struct {
   int fmr;      // half move count for 50 move rule
   int nullply;  // distance from last nullmove
 
+  int threatsReady; // threatened/threatenedBy are computed on first use
+
   uint64_t zobrist;     // zobrist hash of the position
   uint64_t pawnZobrist; // pawn zobrist hash of the position (pawns + stm)
 
@@ -105,13 +126,14 @@ typedef struct {
 
   uint64_t piecesCounts; // "material key" - pieces left on the board
 
-  int squares[64];         // piece per square
+  uint8_t squares[64];     // piece per square
   BitBoard occupancies[3]; // 0 - white pieces, 1 - black pieces, 2 - both
   BitBoard pieces[12];     // individual piece data
 
   int cr[4];
-  int castlingRights[64];
+  uint8_t castlingRights[64];
 
+  // Everything above is the position, copied whole by MakeMoveCopy
   BoardHistory history[MAX_SEARCH_PLY + 100];
 
   Accumulator* accumulators;
@@ -131,11 +153,19 @@ typedef struct {
 
 typedef int16_t PieceTo[12][64];
 
+// Everything keyed by a previous move's (piece, to), kept in one block so
+// the rows a node reads for that move sit on the same couple of pages
+typedef struct {
+  PieceTo ch[2]; // continuation move history (quiet / capture)
+  PieceTo cont;  // continuation correction history
+} ContinuationEntry;
+
 typedef struct {
   int ply, staticEval, de;
   int reduction;
   PieceTo* ch;
   PieceTo* cont;
+  int piece; // piece of ss->move, which is already off its from square
   Move move, skip;
   Move killers[2];
 } SearchStack;
@@ -155,14 +185,17 @@ typedef struct {
   int stopped;
   int quit;
   int multiPV;
+  int splitMultiPV;
   int infinite;
+  int ponderReplies; // pondering on the position before the expected reply, see StartPonderReplies
+  int ponderHit;
   int searchMoves;
   SimpleMoveList searchable;
 } SearchParams;
 
 typedef struct {
   Move move;
-  int seldepth;
+  int depth, seldepth;
   int score, previousScore, avgScore;
   uint64_t nodes;
   PV pv;
@@ -171,8 +204,7 @@ typedef struct {
 enum {
   THREAD_SLEEP,
   THREAD_SEARCH,
-  THREAD_TT_CLEAR,
-  THREAD_SEARCH_CLEAR,
+  THREAD_TASK,
   THREAD_EXIT,
   THREAD_RESUME
 };
@@ -180,9 +212,11 @@ enum {
 typedef struct ThreadData ThreadData;
 
 struct ThreadData {
-  int idx, multiPV, depth, seldepth;
-  atomic_uint_fast64_t nodes, tbhits;
+  // Written every node and read by other threads for the totals, so they
+  // get a cache line to themselves. Only this thread writes them
+  atomic_uint_fast64_t nodes ALIGN, tbhits;
 
+  int idx ALIGN, multiPV, depth, seldepth;
   int nmpMinPly, npmColor;
 
   Accumulator* accumulators;
@@ -195,19 +229,25 @@ struct ThreadData {
   int numRootMoves;
   RootMove rootMoves[MAX_MOVES];
 
+  PV pvs[MAX_SEARCH_PLY + 1]; // triangular pv table, the line found at each ply
+
   Move counters[12][64];         // counter move butterfly table
   int16_t hh[2][2][2][64 * 64];  // history heuristic butterfly table (stm / threatened)
-  int16_t ch[2][12][64][12][64]; // continuation move history table
   int16_t caph[12][64][2][7];    // capture history (piece - to - defeneded - captured_type)
 
   int16_t pawnCorrection[PAWN_CORRECTION_SIZE];
-  int16_t contCorrection[12][64][12][64];
 
-  int action, calls;
+#if defined(LOW_MEMORY)
+  ContinuationEntry (*continuation)[64]; // calloc'd, so only the pages used are resident
+#else
+  ContinuationEntry continuation[12][64] ALIGN; // continuation tables (piece - to)
+#endif
+  uint16_t contEpoch[12][64]; // epoch each continuation entry was last cleared in
+  uint16_t epoch;
+
+  atomic_uint action; // THREAD_SLEEP once done, waited on by ThreadWaitUntilSleep
+  int calls;
   pthread_t nativeThread;
-  pthread_mutex_t mutex;
-  pthread_cond_t sleep;
-  jmp_buf exit;
 };
 
 typedef struct {
@@ -253,13 +293,14 @@ enum {
 typedef struct {
   int score;
   Move move;
+  int16_t see;
 } ScoredMove;
 
 typedef struct {
   ThreadData* thread;
   SearchStack* ss;
   Move hashMove, killer1, killer2, counter;
-  int seeCutoff, phase, genChecks;
+  int seeCutoff, phase, genChecks, see;
 
   ScoredMove *current, *end, *endBad;
   ScoredMove moves[MAX_MOVES];
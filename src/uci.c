@@ -22,9 +22,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 #include "bench.h"
 #include "board.h"
+#include "cluster.h"
 #include "eval.h"
 #include "move.h"
 #include "movegen.h"
@@ -36,20 +38,30 @@
 #include "search.h"
 #include "see.h"
 #include "thread.h"
+#include "topology.h"
 #include "transposition.h"
 #include "util.h"
 
 #define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
 
+#define INPUT_LINES  64 // lines read ahead of the uci thread
+#define INPUT_LENGTH 8192
+
 int MOVE_OVERHEAD  = 50;
 int MULTI_PV       = 1;
+int MULTI_PV_SPLIT = 0;
 int PONDER_ENABLED = 0;
+int PONDER_REPLIES = 1;
 int CHESS_960      = 0;
 int CONTEMPT       = 0;
 int SHOW_WDL       = 1;
 
 SearchParams Limits;
 
+// The last "position" command, the position before the last move is
+// searched when pondering on several replies
+static char lastPosition[8192] = "position startpos";
+
 // All WDL work below is thanks to the work of vondele@ and
 // this repo: https://github.com/vondele/WLD_model
 
@@ -80,10 +92,49 @@ void RootMoves(SimpleMoveList* moves, Board* board) {
     moves->moves[moves->count++] = mv;
 }
 
+// The position of the last "position" command before its last move, 0 if it
+// has no moves or the last one doesn't lead to board
+static int ParentPosition(Board* board, Board* parent) {
+  char text[8192];
+  strcpy(text, lastPosition);
+
+  char* end = text + strlen(text);
+  while (end > text && end[-1] == ' ')
+    *--end = '\0';
+
+  char* moves = strstr(text, "moves");
+  char* last  = strrchr(text, ' ');
+  if (moves == NULL || last < moves + 5)
+    return 0;
+
+  *last = '\0';
+  if (last == moves + 5)
+    *moves = '\0';
+
+  ParsePosition(text, parent);
+
+  SimpleMoveList replies;
+  RootMoves(&replies, parent);
+
+  Board next;
+  for (int i = 0; i < replies.count; i++) {
+    MakeMoveCopy(replies.moves[i], parent, &next);
+    if (next.zobrist == board->zobrist)
+      return 1;
+  }
+
+  return 0;
+}
+
 // uci "go" command
 void ParseGo(char* in, Board* board) {
   in += 3;
 
+  // A search told to stop may still be finishing, and it reads Limits to
+  // the end (a ponder on replies in particular)
+  if (Threads.searching)
+    ThreadWaitUntilSleep(Threads.threads[0]);
+
   Limits.depth            = MAX_SEARCH_PLY;
   Limits.start            = GetTimeMS();
   Limits.timeset          = 0;
@@ -94,6 +145,7 @@ void ParseGo(char* in, Board* board) {
   Limits.searchable.count = 0;
   Limits.infinite         = 0;
   Limits.mate             = 0;
+  Limits.ponderReplies    = 0;
 
   char* ptrChar = in;
   int perft = 0, movesToGo = -1, moveTime = -1, time = -1, inc = 0, depth = -1, nodes = 0, ponder = 0, mate = 0;
@@ -193,7 +245,8 @@ void ParseGo(char* in, Board* board) {
     }
   }
 
-  Limits.multiPV = Min(Limits.multiPV, Limits.searchMoves ? Limits.searchable.count : rootMoves.count);
+  Limits.multiPV      = Min(Limits.multiPV, Limits.searchMoves ? Limits.searchable.count : rootMoves.count);
+  Limits.splitMultiPV = MULTI_PV_SPLIT && Limits.multiPV > 1 && Threads.count > 1;
   if (rootMoves.count == 1 && Limits.timeset)
     Limits.max = Min(250, Limits.max);
 
@@ -211,7 +264,13 @@ void ParseGo(char* in, Board* board) {
     Limits.timeset,
     Limits.searchable.count);
 
-  StartSearch(board, ponder);
+  PonderResult(board);
+
+  static Board parent;
+  if (ponder && PONDER_REPLIES > 1 && ParentPosition(board, &parent))
+    StartPonderReplies(board, &parent, PONDER_REPLIES);
+  else
+    StartSearch(board, ponder);
 }
 
 // uci "position" command
@@ -254,187 +313,460 @@ void PrintUCIOptions() {
   printf("id name Berserk " VERSION "\n");
   printf("id author Jay Honnold\n");
   printf("option name Hash type spin default 16 min 2 max %d\n", HASH_MAX);
+  printf("option name SharedHash type string default <empty>\n");
   printf("option name Threads type spin default 1 min 1 max 2048\n");
+  printf("option name ThreadPinning type check default true\n");
   printf("option name SyzygyPath type string default <empty>\n");
   printf("option name MultiPV type spin default 1 min 1 max 256\n");
+  printf("option name MultiPVSplit type check default false\n");
   printf("option name Ponder type check default false\n");
+  printf("option name PonderReplies type spin default 1 min 1 max 8\n");
   printf("option name UCI_ShowWDL type check default true\n");
   printf("option name UCI_Chess960 type check default false\n");
   printf("option name MoveOverhead type spin default 50 min 0 max 10000\n");
   printf("option name Contempt type spin default 0 min -100 max 100\n");
   printf("option name EvalFile type string default <empty>\n");
+  printf("option name ClusterListen type string default <empty>\n");
   printf("uciok\n");
 }
 
+// Input is read on its own thread into a ring of lines, so the search can
+// be told to stop while the uci thread is still busy with a command
+static char inputLines[INPUT_LINES][INPUT_LENGTH];
+static atomic_uint inputHead, inputTail; // lines read, lines taken
+
+static void* ReadInput(void* arg) {
+  (void) arg;
+
+  int open = 1;
+  while (open) {
+    unsigned head = atomic_load(&inputHead), tail;
+    while (head - (tail = atomic_load(&inputTail)) == INPUT_LINES)
+      WaitWhileEqual(&inputTail, tail);
+
+    // an empty line marks the end of input
+    char* line = inputLines[head % INPUT_LINES];
+    open       = fgets(line, INPUT_LENGTH, stdin) != NULL;
+    line[open ? strcspn(line, "\r\n") : 0] = '\0';
+
+    if (open && !line[0])
+      continue;
+
+    // With nothing queued ahead of it, a stop can only be meant for the
+    // search already running and doesn't have to wait its turn
+    if ((!strcmp(line, "stop") || !strcmp(line, "quit")) && atomic_load(&inputTail) == head)
+      StopSearch();
+
+    atomic_store(&inputHead, head + 1);
+    WakeAll(&inputHead);
+  }
+
+  return NULL;
+}
+
 int ReadLine(char* in) {
-  if (fgets(in, 8192, stdin) == NULL)
-    return 0;
+  unsigned tail = atomic_load(&inputTail);
+  while (atomic_load(&inputHead) == tail)
+    WaitWhileEqual(&inputHead, tail);
+
+  strcpy(in, inputLines[tail % INPUT_LINES]);
+  atomic_store(&inputTail, tail + 1);
+  WakeAll(&inputTail);
+
+  return in[0] != '\0';
+}
+
+static int quit;
+
+static void IsReadyCommand(char* in, Board* board) {
+  (void) in;
+  (void) board;
+
+  printf("readyok\n");
+}
+
+static void PositionCommand(char* in, Board* board) {
+  strcpy(lastPosition, in); // ParsePosition tokenizes in
+
+  ParsePosition(in, board);
+  ClusterSetPosition(lastPosition, board->zobrist);
+}
+
+static void NewGameCommand(char* in, Board* board) {
+  (void) in;
 
-  size_t c = strcspn(in, "\r\n");
-  if (c < strlen(in))
-    in[c] = '\0';
+  strcpy(lastPosition, "position startpos");
+  ParsePosition("position startpos\n", board);
+  NewGameClear();
+}
+
+static void StopCommand(char* in, Board* board) {
+  (void) in;
+  (void) board;
+
+  StopSearch();
+}
+
+static void QuitCommand(char* in, Board* board) {
+  (void) in;
+  (void) board;
+
+  StopSearch();
+  quit = 1;
+}
+
+static void UCICommand(char* in, Board* board) {
+  (void) in;
+  (void) board;
+
+  PrintUCIOptions();
+}
+
+static void PonderHitCommand(char* in, Board* board) {
+  (void) in;
+
+  if (Limits.ponderReplies) {
+    PonderHit(board);
+    return;
+  }
+
+  Threads.ponder = 0;
+  if (Threads.stopOnPonderHit)
+    Threads.stop = 1;
+  TimerWake();
+  pthread_mutex_lock(&Threads.lock);
+  if (Threads.sleeping) {
+    Threads.stop = 1;
+    ThreadWake(Threads.threads[0], THREAD_RESUME);
+    Threads.sleeping = 0;
+  }
+  pthread_mutex_unlock(&Threads.lock);
+}
+
+static void BoardCommand(char* in, Board* board) {
+  (void) in;
+
+  PrintBoard(board);
+}
+
+static void CycleCommand(char* in, Board* board) {
+  (void) in;
 
-  return 1;
+  int cycle = HasCycle(board, MAX_SEARCH_PLY);
+  printf(cycle ? "yes\n" : "no\n");
 }
 
+static void PerftCommand(char* in, Board* board) {
+  strtok(in, " ");
+  char* d   = strtok(NULL, " ") ?: "5";
+  char* fen = strtok(NULL, "\0") ?: START_FEN;
+
+  int depth = atoi(d);
+  ParseFen(fen, board);
+
+  PerftTest(depth, board);
+}
+
+// Benchmarks taking a single number, or its default
+static int NumberArgument(char* in, char* fallback) {
+  strtok(in, " ");
+  return atoi(strtok(NULL, " ") ?: fallback);
+}
+
+static void MultiPVBenchCommand(char* in, Board* board) {
+  (void) board;
+
+  MultiPVBench(NumberArgument(in, "1000"));
+}
+
+static void HandoffBenchCommand(char* in, Board* board) {
+  (void) board;
+
+  HandoffBench(NumberArgument(in, "64"));
+}
+
+static void ClusterBenchCommand(char* in, Board* board) {
+  (void) board;
+
+  ClusterBench(NumberArgument(in, "12"));
+}
+
+static void BenchCommand(char* in, Board* board) {
+  (void) board;
+
+  Bench(NumberArgument(in, "13"));
+}
+
+static void TopologyCommand(char* in, Board* board) {
+  (void) in;
+  (void) board;
+
+  PrintTopology();
+}
+
+static void ThreatsCommand(char* in, Board* board) {
+  (void) in;
+
+  PrintBB(Threatened(board));
+}
+
+static void EvalCommand(char* in, Board* board) {
+  (void) in;
+
+  EvaluateTrace(board);
+}
+
+static void SEECommand(char* in, Board* board) {
+  char* move = strchr(in, ' ');
+  Move m     = move ? ParseMove(move + 1, board) : NULL_MOVE;
+  if (m)
+    printf("info string SEE result: %d\n", SEE(board, m, 0));
+  else
+    printf("info string Invalid move!\n");
+}
+
+static void ApplyCommand(char* in, Board* board) {
+  char* move = strchr(in, ' ');
+  Move m     = move ? ParseMove(move + 1, board) : NULL_MOVE;
+  if (m) {
+    MakeMoveUpdate(m, board, 0);
+    PrintBoard(board);
+  } else
+    printf("info string Invalid move!\n");
+}
+
+static int IsTrue(char* value) {
+  return !strncmp(value, "true", 4);
+}
+
+static void SetHashOption(char* value, Board* board) {
+  (void) board;
+
+  int mb                  = Max(2, Min(HASH_MAX, atoi(value)));
+  uint64_t bytesAllocated = TTInit(mb);
+  uint64_t totalEntries   = BUCKET_SIZE * bytesAllocated / sizeof(TTBucket);
+  printf("info string set Hash to value %d (%" PRIu64 " bytes) (%" PRIu64 " entries)\n",
+         mb,
+         bytesAllocated,
+         totalEntries);
+}
+
+static void SetSharedHashOption(char* value, Board* board) {
+  (void) board;
+
+  uint64_t bytesAllocated = TTShare(strncmp(value, "<empty>", 7) ? value : NULL);
+  printf("info string set SharedHash to value %s (%" PRIu64 " bytes)\n",
+         TT.name[0] ? TT.name : "<empty>",
+         bytesAllocated);
+}
+
+static void SetThreadsOption(char* value, Board* board) {
+  (void) board;
+
+  ThreadsSetNumber(Max(1, Min(2048, atoi(value))));
+  printf("info string set Threads to value %d (%" PRIu64 " bytes per thread)\n", Threads.count, ThreadMemory());
+}
+
+static void SetThreadPinningOption(char* value, Board* board) {
+  (void) board;
+
+  THREAD_PINNING = IsTrue(value);
+  ThreadsPin();
+  printf("info string set ThreadPinning to value %s\n", THREAD_PINNING ? "true" : "false");
+}
+
+static void SetSyzygyPathOption(char* value, Board* board) {
+  (void) board;
+
+  int success = tb_init(value);
+  if (success)
+    printf("info string set SyzygyPath to value %s\n", value);
+  else
+    printf("info string FAILED!\n");
+}
+
+static void SetMultiPVOption(char* value, Board* board) {
+  (void) board;
+
+  MULTI_PV = Max(1, Min(256, atoi(value)));
+  printf("info string set MultiPV to value %d\n", MULTI_PV);
+}
+
+static void SetMultiPVSplitOption(char* value, Board* board) {
+  (void) board;
+
+  MULTI_PV_SPLIT = IsTrue(value);
+  printf("info string set MultiPVSplit to value %s\n", MULTI_PV_SPLIT ? "true" : "false");
+}
+
+static void SetPonderOption(char* value, Board* board) {
+  (void) board;
+
+  PONDER_ENABLED = IsTrue(value);
+  printf("info string set Ponder to value %s\n", PONDER_ENABLED ? "true" : "false");
+}
+
+static void SetPonderRepliesOption(char* value, Board* board) {
+  (void) board;
+
+  PONDER_REPLIES = Min(8, Max(1, atoi(value)));
+  printf("info string set PonderReplies to value %d\n", PONDER_REPLIES);
+}
+
+static void SetShowWDLOption(char* value, Board* board) {
+  (void) board;
+
+  SHOW_WDL = IsTrue(value);
+  printf("info string set SHOW_WDL to value %s\n", SHOW_WDL ? "true" : "false");
+}
+
+static void SetChess960Option(char* value, Board* board) {
+  CHESS_960 = IsTrue(value);
+  printf("info string set UCI_Chess960 to value %s\n", CHESS_960 ? "true" : "false");
+  printf("info string Resetting board...\n");
+
+  strcpy(lastPosition, "position startpos");
+  ParsePosition("position startpos\n", board);
+  NewGameClear();
+}
+
+static void SetMoveOverheadOption(char* value, Board* board) {
+  (void) board;
+
+  MOVE_OVERHEAD = Min(10000, Max(0, atoi(value)));
+}
+
+static void SetContemptOption(char* value, Board* board) {
+  (void) board;
+
+  CONTEMPT = Min(100, Max(-100, atoi(value)));
+}
+
+static void SetEvalFileOption(char* value, Board* board) {
+  (void) board;
+
+  int success = 0;
+
+  if (strncmp(value, "<empty>", 7))
+    success = LoadNetwork(value);
+  else {
+    LoadDefaultNN();
+    success = 1;
+  }
+
+  if (success)
+    printf("info string set EvalFile to value %s\n", value);
+}
+
+static void SetClusterListenOption(char* value, Board* board) {
+  (void) board;
+
+  if (strncmp(value, "<empty>", 7) && ClusterListen(value))
+    printf("info string set ClusterListen to value %s\n", value);
+  else
+    printf("info string FAILED!\n");
+}
+
+typedef struct {
+  const char* name;
+  void (*run)(char* in, Board* board); // in is the whole line, an option gets its value
+} Handler;
+
+static const Handler options[] = {
+  {"Hash", SetHashOption},
+  {"SharedHash", SetSharedHashOption},
+  {"Threads", SetThreadsOption},
+  {"ThreadPinning", SetThreadPinningOption},
+  {"SyzygyPath", SetSyzygyPathOption},
+  {"MultiPV", SetMultiPVOption},
+  {"MultiPVSplit", SetMultiPVSplitOption},
+  {"Ponder", SetPonderOption},
+  {"PonderReplies", SetPonderRepliesOption},
+  {"UCI_ShowWDL", SetShowWDLOption},
+  {"UCI_Chess960", SetChess960Option},
+  {"MoveOverhead", SetMoveOverheadOption},
+  {"Contempt", SetContemptOption},
+  {"EvalFile", SetEvalFileOption},
+  {"ClusterListen", SetClusterListenOption},
+};
+
+// "setoption name <name> value <value>", the value runs to the end of the line
+static void SetOptionCommand(char* in, Board* board) {
+  char* name  = strstr(in, " name ");
+  char* value = strstr(in, " value ");
+
+  if (name && value && value > name) {
+    name += 6;
+    *value = '\0';
+    value += 7;
+
+    for (size_t i = 0; i < sizeof(options) / sizeof(Handler); i++)
+      if (!strcasecmp(name, options[i].name)) {
+        options[i].run(value, board);
+        return;
+      }
+
+    value[-7] = ' ';
+  }
+
+  printf("Unknown command: %s \n", in);
+}
+
+static const Handler commands[] = {
+  {"isready", IsReadyCommand},
+  {"position", PositionCommand},
+  {"ucinewgame", NewGameCommand},
+  {"go", ParseGo},
+  {"stop", StopCommand},
+  {"quit", QuitCommand},
+  {"uci", UCICommand},
+  {"ponderhit", PonderHitCommand},
+  {"setoption", SetOptionCommand},
+  {"board", BoardCommand},
+  {"cycle", CycleCommand},
+  {"perft", PerftCommand},
+  {"multipvbench", MultiPVBenchCommand},
+  {"handoffbench", HandoffBenchCommand},
+  {"clusterbench", ClusterBenchCommand},
+  {"bench", BenchCommand},
+  {"topology", TopologyCommand},
+  {"threats", ThreatsCommand},
+  {"eval", EvalCommand},
+  {"see", SEECommand},
+  {"apply", ApplyCommand},
+};
+
 void UCILoop() {
-  static char in[8192];
+  static char in[INPUT_LENGTH];
 
   Board board;
   ParseFen(START_FEN, &board);
 
+  // Every message leaves in a single write. Windows has no line buffering,
+  // there it's unbuffered as before
+#if defined(_WIN32)
   setbuf(stdout, NULL);
+#else
+  setvbuf(stdout, NULL, _IOLBF, 1 << 16);
+#endif
 
   Threads.searching = Threads.sleeping = 0;
 
-  while (ReadLine(in)) {
-    if (in[0] == '\n')
-      continue;
+  pthread_t reader;
+  pthread_create(&reader, NULL, ReadInput, NULL);
+  pthread_detach(reader);
 
-    if (!strncmp(in, "isready", 7)) {
-      printf("readyok\n");
-    } else if (!strncmp(in, "position", 8)) {
-      ParsePosition(in, &board);
-    } else if (!strncmp(in, "ucinewgame", 10)) {
-      ParsePosition("position startpos\n", &board);
-      TTClear();
-      SearchClear();
-    } else if (!strncmp(in, "go", 2)) {
-      ParseGo(in, &board);
-    } else if (!strncmp(in, "stop", 4)) {
-      if (Threads.searching) {
-        Threads.stop = 1;
-        pthread_mutex_lock(&Threads.lock);
-        if (Threads.sleeping)
-          ThreadWake(Threads.threads[0], THREAD_RESUME);
-        Threads.sleeping = 0;
-        pthread_mutex_unlock(&Threads.lock);
-      }
-    } else if (!strncmp(in, "quit", 4)) {
-      if (Threads.searching) {
-        Threads.stop = 1;
-        pthread_mutex_lock(&Threads.lock);
-        if (Threads.sleeping)
-          ThreadWake(Threads.threads[0], THREAD_RESUME);
-        Threads.sleeping = 0;
-        pthread_mutex_unlock(&Threads.lock);
-      }
-      break;
-    } else if (!strncmp(in, "uci", 3)) {
-      PrintUCIOptions();
-    } else if (!strncmp(in, "ponderhit", 9)) {
-      Threads.ponder = 0;
-      if (Threads.stopOnPonderHit)
-        Threads.stop = 1;
-      pthread_mutex_lock(&Threads.lock);
-      if (Threads.sleeping) {
-        Threads.stop = 1;
-        ThreadWake(Threads.threads[0], THREAD_RESUME);
-        Threads.sleeping = 0;
-      }
-      pthread_mutex_unlock(&Threads.lock);
-    } else if (!strncmp(in, "board", 5)) {
-      PrintBoard(&board);
-    } else if (!strncmp(in, "cycle", 5)) {
-      int cycle = HasCycle(&board, MAX_SEARCH_PLY);
-      printf(cycle ? "yes\n" : "no\n");
-    } else if (!strncmp(in, "perft", 5)) {
-      strtok(in, " ");
-      char* d   = strtok(NULL, " ") ?: "5";
-      char* fen = strtok(NULL, "\0") ?: START_FEN;
-
-      int depth = atoi(d);
-      ParseFen(fen, &board);
-
-      PerftTest(depth, &board);
-    } else if (!strncmp(in, "bench", 5)) {
-      strtok(in, " ");
-      char* d = strtok(NULL, " ") ?: "13";
-
-      int depth = atoi(d);
-      Bench(depth);
-    } else if (!strncmp(in, "threats", 7)) {
-      PrintBB(board.threatened);
-    } else if (!strncmp(in, "eval", 4)) {
-      EvaluateTrace(&board);
-    } else if (!strncmp(in, "see ", 4)) {
-      Move m = ParseMove(in + 4, &board);
-      if (m)
-        printf("info string SEE result: %d\n", SEE(&board, m, 0));
-      else
-        printf("info string Invalid move!\n");
-    } else if (!strncmp(in, "apply ", 6)) {
-      Move m = ParseMove(in + 6, &board);
-      if (m) {
-        MakeMoveUpdate(m, &board, 0);
-        PrintBoard(&board);
-      } else
-        printf("info string Invalid move!\n");
-    } else if (!strncmp(in, "setoption name Hash value ", 26)) {
-      int mb                  = GetOptionIntValue(in);
-      mb                      = Max(2, Min(HASH_MAX, mb));
-      uint64_t bytesAllocated = TTInit(mb);
-      uint64_t totalEntries   = BUCKET_SIZE * bytesAllocated / sizeof(TTBucket);
-      printf("info string set Hash to value %d (%" PRIu64 " bytes) (%" PRIu64 " entries)\n",
-             mb,
-             bytesAllocated,
-             totalEntries);
-    } else if (!strncmp(in, "setoption name Threads value ", 29)) {
-      int n = GetOptionIntValue(in);
-      ThreadsSetNumber(Max(1, Min(2048, n)));
-      printf("info string set Threads to value %d\n", Threads.count);
-    } else if (!strncmp(in, "setoption name SyzygyPath value ", 32)) {
-      int success = tb_init(in + 32);
-      if (success)
-        printf("info string set SyzygyPath to value %s\n", in + 32);
-      else
-        printf("info string FAILED!\n");
-    } else if (!strncmp(in, "setoption name MultiPV value ", 29)) {
-      int n = GetOptionIntValue(in);
-
-      MULTI_PV = Max(1, Min(256, n));
-      printf("info string set MultiPV to value %d\n", MULTI_PV);
-    } else if (!strncmp(in, "setoption name Ponder value ", 28)) {
-      char opt[6];
-      sscanf(in, "%*s %*s %*s %*s %5s", opt);
-
-      PONDER_ENABLED = !strncmp(opt, "true", 4);
-      printf("info string set Ponder to value %s\n", PONDER_ENABLED ? "true" : "false");
-    } else if (!strncmp(in, "setoption name UCI_ShowWDL value ", 33)) {
-      char opt[6];
-      sscanf(in, "%*s %*s %*s %*s %5s", opt);
-
-      SHOW_WDL = !strncmp(opt, "true", 4);
-      printf("info string set SHOW_WDL to value %s\n", SHOW_WDL ? "true" : "false");
-    } else if (!strncmp(in, "setoption name UCI_Chess960 value ", 34)) {
-      char opt[6];
-      sscanf(in, "%*s %*s %*s %*s %5s", opt);
-
-      CHESS_960 = !strncmp(opt, "true", 4);
-      printf("info string set UCI_Chess960 to value %s\n", CHESS_960 ? "true" : "false");
-      printf("info string Resetting board...\n");
-
-      ParsePosition("position startpos\n", &board);
-      TTClear();
-      SearchClear();
-    } else if (!strncmp(in, "setoption name MoveOverhead value ", 34)) {
-      MOVE_OVERHEAD = Min(10000, Max(0, GetOptionIntValue(in)));
-    } else if (!strncmp(in, "setoption name Contempt value ", 30)) {
-      CONTEMPT = Min(100, Max(-100, GetOptionIntValue(in)));
-    } else if (!strncmp(in, "setoption name EvalFile value ", 30)) {
-      char* path  = in + 30;
-      int success = 0;
-
-      if (strncmp(path, "<empty>", 7))
-        success = LoadNetwork(path);
-      else {
-        LoadDefaultNN();
-        success = 1;
-      }
+  while (!quit && ReadLine(in)) {
+    size_t length = strcspn(in, " ");
+
+    size_t i = 0;
+    while (i < sizeof(commands) / sizeof(Handler) &&
+           (strlen(commands[i].name) != length || strncmp(in, commands[i].name, length)))
+      i++;
 
-      if (success)
-        printf("info string set EvalFile to value %s\n", path);
-    } else
+    if (i < sizeof(commands) / sizeof(Handler))
+      commands[i].run(in, &board);
+    else
       printf("Unknown command: %s \n", in);
   }
 
@@ -444,10 +776,3 @@ void UCILoop() {
   pthread_mutex_destroy(&Threads.lock);
   ThreadsExit();
 }
-
-int GetOptionIntValue(char* in) {
-  int n;
-  sscanf(in, "%*s %*s %*s %*s %d", &n);
-
-  return n;
-}
@@ -19,6 +19,8 @@
 
 #include "types.h"
 
+extern int MULTI_PV_SPLIT;
+extern int PONDER_REPLIES;
 extern int SHOW_WDL;
 extern int CHESS_960;
 extern int CONTEMPT;
@@ -38,6 +40,4 @@ void PrintUCIOptions();
 int ReadLine(char* in);
 void UCILoop();
 
-int GetOptionIntValue(char* in);
-
 #endif
\ No newline at end of file
@@ -19,12 +19,33 @@
 #ifdef WIN32
 #include <windows.h>
 
+#include <psapi.h>
+
 long GetTimeMS() {
   return GetTickCount();
 }
 
+int64_t GetTimeUS() {
+  LARGE_INTEGER freq, count;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+
+  return count.QuadPart / freq.QuadPart * 1000000 + count.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart;
+}
+
+int64_t GetPrivateMemoryKB() {
+  PROCESS_MEMORY_COUNTERS_EX counters;
+  if (!K32GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*) &counters, sizeof(counters)))
+    return 0;
+
+  return counters.PrivateUsage / 1024;
+}
+
 #else
+#include <inttypes.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <sys/resource.h>
 #include <sys/time.h>
 
 long GetTimeMS() {
@@ -34,4 +55,39 @@ long GetTimeMS() {
   return time.tv_sec * 1000 + time.tv_usec / 1000;
 }
 
+int64_t GetTimeUS() {
+  struct timeval time;
+  gettimeofday(&time, NULL);
+
+  return (int64_t) time.tv_sec * 1000000 + time.tv_usec;
+}
+
+// Resident memory not backed by the binary, which is what each extra
+// instance costs. Elsewhere the peak resident size is the best we have
+int64_t GetPrivateMemoryKB() {
+#if defined(__linux__)
+  FILE* fin = fopen("/proc/self/status", "r");
+  if (fin == NULL)
+    return 0;
+
+  char line[256];
+  int64_t kb = 0;
+  while (fgets(line, sizeof(line), fin))
+    if (sscanf(line, "RssAnon: %" SCNd64, &kb) == 1)
+      break;
+
+  fclose(fin);
+  return kb;
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+#if defined(__APPLE__)
+  return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+  return usage.ru_maxrss;
+#endif
+#endif
+}
+
 #endif
@@ -31,7 +31,13 @@
 #define IncRlx(x)  atomic_fetch_add_explicit(&(x), 1, memory_order_relaxed)
 #define DecRlx(x)  atomic_fetch_sub_explicit(&(x), 1, memory_order_relaxed)
 
+// Increment a counter only its owning thread writes, others just read it.
+// A load and store avoids the locked read-modify-write of IncRlx
+#define IncOwnRlx(x) atomic_store_explicit(&(x), LoadRlx(x) + 1, memory_order_relaxed)
+
 long GetTimeMS();
+int64_t GetTimeUS();
+int64_t GetPrivateMemoryKB();
 
 INLINE void* AlignedMalloc(uint64_t size, const size_t on) {
   void* mem  = malloc(size + on + sizeof(void*));
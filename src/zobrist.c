@@ -20,6 +20,7 @@
 #include "random.h"
 #include "types.h"
 
+#ifndef PREBUILT_TABLES
 uint64_t ZOBRIST_PIECES[12][64];
 uint64_t ZOBRIST_EP_KEYS[64];
 uint64_t ZOBRIST_CASTLE_KEYS[16];
@@ -38,6 +39,7 @@ void InitZobristKeys() {
 
   ZOBRIST_SIDE_KEY = RandomUInt64();
 }
+#endif
 
 // Generate a Zobrist key for the current board state
 uint64_t Zobrist(Board* board) {
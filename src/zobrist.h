@@ -22,10 +22,10 @@
 #include "types.h"
 #include "util.h"
 
-extern uint64_t ZOBRIST_PIECES[12][64];
-extern uint64_t ZOBRIST_EP_KEYS[64];
-extern uint64_t ZOBRIST_CASTLE_KEYS[16];
-extern uint64_t ZOBRIST_SIDE_KEY;
+extern TABLE uint64_t ZOBRIST_PIECES[12][64];
+extern TABLE uint64_t ZOBRIST_EP_KEYS[64];
+extern TABLE uint64_t ZOBRIST_CASTLE_KEYS[16];
+extern TABLE uint64_t ZOBRIST_SIDE_KEY;
 
 void InitZobristKeys();
 uint64_t Zobrist(Board* board);
@@ -37,7 +37,7 @@ INLINE uint64_t KeyAfter(Board* board, const Move move) {
 
   const int from   = From(move);
   const int to     = To(move);
-  const int moving = Moving(move);
+  const int moving = Moving(board, move);
 
   uint64_t newKey = board->zobrist ^ ZOBRIST_SIDE_KEY ^ ZOBRIST_PIECES[moving][from] ^ ZOBRIST_PIECES[moving][to];
 
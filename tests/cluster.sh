@@ -0,0 +1,45 @@
+#!/bin/bash
+# a coordinator and two workers on one host search together
+
+error() {
+  >&2 echo "cluster testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "cluster testing started"
+
+dir=$(mktemp -d)
+trap 'kill $(jobs -p) 2>/dev/null || true; rm -rf "$dir"' EXIT
+
+wait_for() {
+  for i in $(seq 300); do
+    [ "$(grep -c "$1" "$dir/out")" -ge "$2" ] && return 0
+    sleep 0.1
+  done
+  return 1
+}
+
+mkfifo "$dir/in"
+./src/berserk < "$dir/in" > "$dir/out" &
+exec 3> "$dir/in"
+
+echo "setoption name ClusterListen value $dir/sock" >&3
+./src/berserk worker "$dir/sock" > /dev/null &
+./src/berserk worker "$dir/sock" > /dev/null &
+wait_for "cluster peer . connected" 2
+
+echo "position fen 7k/8/8/8/8/8/6q1/7K w - -" >&3
+echo "go depth 10" >&3
+wait_for "bestmove h1g2" 1
+
+echo "ucinewgame" >&3
+echo "position startpos moves e2e4 e7e5" >&3
+echo "go movetime 500" >&3
+wait_for "bestmove" 2
+
+echo "quit" >&3
+exec 3>&-
+wait
+
+echo "cluster testing OK"